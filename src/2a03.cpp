@@ -28,6 +28,7 @@
 #include "include/mappers/c_mapper.h"
 #include "include/c_nes.h"
 #include "include/c_rom.h"
+#include "include/2a03_dynarec.h"
 #include "include/datatypes.h"
 
 #define IMM 0
@@ -45,18 +46,13 @@
 #define JMP 12
 #define NIL 13
 
-void _2A03_disassembleInstruction(__INT_32);
+void _2A03_trace_instruction(__UINT_16);
 void _2A03_disassemblePRGROM(void);
 void _2A03_dumpPTTables(__UINT_8);
 int write_address(char *operands, int dat);
 void add_warning(char *operands, int code_jmp);
 
-int base_addr = 0x12345678;
-int idx_addr;
-int jump_addr;
-int last_y = 0x12345678;
-int last_x = 0x12345678;
-int warnings;
+__THREAD_LOCAL int warnings;
 
 static const char *_2A03_instructionSet[] =
 {
@@ -145,11 +141,16 @@ static __UINT_8 _2A03_instructionAddrMode[] =
 	IMP, ABY, NIL, NIL, NIL, ABX, ABX, NIL      // 0xf8
 };
 
+// Instructions lengths by addressing mode
+
+static __UINT_8 _2A03_addrModeLength[] =
+{
+	2, 2, 2, 2, 3, 3, 3, 3, 2, 2, 1, 2, 3, 1
+};
+
 //Cycles Counts - as specified in official Rockwell 6502 docs.
 
-static __UINT_32 *_2A03_cycleCounts;
 
-static __UINT_32 _2A03_PPUCycleCounts[0x100];
 
 static __UINT_32 _2A03_regularCycleCounts[] =
 {
@@ -171,9 +172,7 @@ static __UINT_32 _2A03_regularCycleCounts[] =
 	2, 5, 0, 0, 0, 4, 6, 0, 2, 4, 0, 0, 0, 4, 7, 0
 };
 
-static __INT_32 *_2A03_accessCycles;
 
-static __INT_32 _2A03_PPUAccessCycles[0x100];
 
 static __INT_32 _2A03_regularAccessCycles[] =
 {
@@ -195,13 +194,35 @@ static __INT_32 _2A03_regularAccessCycles[] =
 	0, 0, 0, 0, 0, 0, 0, 0,	0, 0, 0, 0, 0, 0, 0, 0
 };
 
+// Instructions writing to memory (stores and read-modify-write)
+
+static __UINT_8 _2A03_memoryWrites[] =
+{
+	0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0,
+	0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0,
+	0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0,
+	0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0,
+	0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0,
+	0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0,
+	0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0,
+	0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0,
+	0, 1, 0, 0, 1, 1, 1, 0, 0, 0, 0, 0, 1, 1, 1, 0,
+	0, 1, 0, 0, 1, 1, 1, 0, 0, 1, 0, 0, 0, 1, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0,
+	0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0,
+	0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0,
+	0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0
+};
+
 #define _2A03_FIX_CYCLES(Count) ((Count) * 3 * 16)
 
 /******************************************************************************/
 /** External Data		                                                     **/
 /******************************************************************************/
 
-extern c_machine *o_machine;
+extern __THREAD_LOCAL c_machine *o_machine;
 
 /******************************************************************************/
 /** Memory Access Functions                                                  **/
@@ -217,6 +238,8 @@ extern c_machine *o_machine;
 #define NESRAM_readWord nes->o_ram->read_word
 #define NESCTL_write_byte nes->o_control->write_byte
 #define NESRAM_write_byte nes->o_ram->write_byte
+#define NESCTL_ReadData _2A03_read_data<LABELS>
+#define NESCTL_ReadIndirectData _2A03_read_indirect_data<LABELS>
 
 /******************************************************************************/
 /** Internal Registers                                                       **/
@@ -224,18 +247,287 @@ extern c_machine *o_machine;
 /** Description:															 **/
 /******************************************************************************/
 
-__BOOL _2A03_instructionDumper, _2A03_instructionLog,
-								_2A03_labelHolder,
-                                _2A03_IRQLine,
-                                _2A03_IRQRequested,
-                                _2A03_NMIRequested,
-                                _2A03_NMISecondRequested,
-                                _2A03_unfinishedOp;
-static __UINT_8 S, X, Y, tmpByte, SP;
-__UINT_16 A, tmpAddress, IRQAddr, NMIAddr, resetAddr;
-static AWORD PC, tmpWord;
-static __INT_32 tmpInt;
-static __INT_32 iCurrentTime, iEndTime;
+__THREAD_LOCAL s_2A03_context *_2A03_cpu;
+
+template <int LABELS, int LOG> static void _2A03_run_mode(void);
+
+void _2A03_init_context(s_2A03_context *context)
+{
+	memset(context, 0, sizeof(s_2A03_context));
+	context->base_addr = 0x12345678;
+	context->last_x = 0x12345678;
+	context->last_y = 0x12345678;
+	context->run = _2A03_run_mode<FALSE, FALSE>;
+}
+
+// All the _2A03_* functions called from this thread will use it
+void _2A03_set_context(s_2A03_context *context)
+{
+	_2A03_cpu = context;
+}
+
+// The registers of the current context
+
+#define _2A03_labelHolder (_2A03_cpu->labelHolder)
+#define _2A03_instructionDumper (_2A03_cpu->instructionDumper)
+#define _2A03_instructionLog (_2A03_cpu->instructionLog)
+#define _2A03_IRQLine (_2A03_cpu->IRQLine)
+#define _2A03_IRQRequested (_2A03_cpu->IRQRequested)
+#define _2A03_NMIRequested (_2A03_cpu->NMIRequested)
+#define _2A03_NMISecondRequested (_2A03_cpu->NMISecondRequested)
+#define _2A03_events (_2A03_cpu->events)
+#define _2A03_run_ahead (_2A03_cpu->run_ahead)
+#define _2A03_unfinishedOp (_2A03_cpu->unfinishedOp)
+#define S (_2A03_cpu->S)
+#define X (_2A03_cpu->X)
+#define Y (_2A03_cpu->Y)
+#define SP (_2A03_cpu->SP)
+#define A (_2A03_cpu->A)
+#define PC (_2A03_cpu->PC)
+#define tmpByte (_2A03_cpu->tmpByte)
+#define tmpAddress (_2A03_cpu->tmpAddress)
+#define tmpWord (_2A03_cpu->tmpWord)
+#define _2A03_operand (_2A03_cpu->operand)
+#define tmpInt (_2A03_cpu->tmpInt)
+#define iCurrentTime (_2A03_cpu->iCurrentTime)
+#define iEndTime (_2A03_cpu->iEndTime)
+#define base_addr (_2A03_cpu->base_addr)
+#define idx_addr (_2A03_cpu->idx_addr)
+#define jump_addr (_2A03_cpu->jump_addr)
+#define last_x (_2A03_cpu->last_x)
+#define last_y (_2A03_cpu->last_y)
+#define IRQAddr (_2A03_cpu->IRQAddr)
+#define NMIAddr (_2A03_cpu->NMIAddr)
+#define resetAddr (_2A03_cpu->resetAddr)
+#define _2A03_cycleCounts (_2A03_cpu->cycleCounts)
+#define _2A03_PPUCycleCounts (_2A03_cpu->PPUCycleCounts)
+#define _2A03_accessCycles (_2A03_cpu->accessCycles)
+#define _2A03_PPUAccessCycles (_2A03_cpu->PPUAccessCycles)
+
+/******************************************************************************/
+/** Code/Data Logging                                                        **/
+/**																			 **/
+/** Description:															 **/
+/******************************************************************************/
+
+__inline void _2A03_log_prg(__UINT_16 address, __UINT_8 flags)
+{
+	if(address > 0x7fff)
+	{
+		nes->o_cdl->log_prg(nes->o_cpu->get_rom_offset(address), address, flags);
+	}
+}
+
+__inline void _2A03_log_code(__UINT_16 address, __UINT_8 instruction, s_2A03_decoded *decoded)
+{
+	register int length = _2A03_addrModeLength[_2A03_instructionAddrMode[instruction]];
+	register __UINT_8 window = 1 << ((address >> 13) & 3);
+
+	// Nothing new to log if it ran from the same window before
+	if(decoded && (decoded->code_windows & window))
+	{
+		return;
+	}
+	// (unless it spans 2 banks)
+	if(decoded && (address & 0xfff) + length <= 0x1000)
+	{
+		decoded->code_windows |= window;
+	}
+	while(length--)
+	{
+		_2A03_log_prg(address++, CDL_PRG_CODE);
+	}
+}
+
+template <int LABELS> __inline __UINT_8 _2A03_read_data(__UINT_16 address)
+{
+	if(LABELS)
+	{
+		_2A03_log_prg(address, CDL_PRG_DATA);
+	}
+	return NESCTL_ReadByte(address);
+}
+
+template <int LABELS> __inline __UINT_8 _2A03_read_indirect_data(__UINT_16 address)
+{
+	if(LABELS)
+	{
+		_2A03_log_prg(address, CDL_PRG_DATA | CDL_PRG_INDIRECT_DATA);
+	}
+	return NESCTL_ReadByte(address);
+}
+
+/******************************************************************************/
+/** Decoded Instructions                                                     **/
+/**																			 **/
+/** Description:															 **/
+/******************************************************************************/
+
+// Returns NULL if the instruction isn't read from the PRG-ROM
+// (code running from RAM, spanning 2 banks or patched by a genie)
+__inline s_2A03_decoded *_2A03_decode(__UINT_16 address)
+{
+	register s_2A03_decoded *decoded;
+	register int offset;
+	register int length;
+
+	if(address < 0x8000)
+	{
+		return NULL;
+	}
+	offset = nes->o_cpu->get_rom_offset(address);
+	decoded = &_2A03_cpu->decoded[offset];
+	if(!decoded->is_valid)
+	{
+		decoded->opcode = nes->o_cpu->PRGROM[offset];
+		decoded->cycles = _2A03_cycleCounts[decoded->opcode];
+		decoded->has_access = _2A03_accessCycles[decoded->opcode] ? TRUE : FALSE;
+		length = _2A03_addrModeLength[_2A03_instructionAddrMode[decoded->opcode]];
+		decoded->operand = 0;
+		if((address & 0xfff) + length <= 0x1000)
+		{
+			if(length > 1)
+			{
+				decoded->operand = nes->o_cpu->PRGROM[offset + 1];
+			}
+			if(length > 2)
+			{
+				decoded->operand |= nes->o_cpu->PRGROM[offset + 2] << 8;
+			}
+		}
+		decoded->is_valid = TRUE;
+	}
+	length = _2A03_addrModeLength[_2A03_instructionAddrMode[decoded->opcode]];
+	if((address & 0xfff) + length > 0x1000 || nes->o_control->is_patched(address, length))
+	{
+		return NULL;
+	}
+	return decoded;
+}
+
+__inline __UINT_16 _2A03_fetch_operand(__UINT_16 address, __UINT_8 instruction)
+{
+	register int length = _2A03_addrModeLength[_2A03_instructionAddrMode[instruction]];
+	register __UINT_16 operand = 0;
+
+	if(length > 1)
+	{
+		operand = NESPRGRAM_ReadByte(address + 1);
+	}
+	if(length > 2)
+	{
+		operand |= NESPRGRAM_ReadByte(address + 2) << 8;
+	}
+	return operand;
+}
+
+/******************************************************************************/
+/** Translated Blocks                                                        **/
+/**																			 **/
+/** Description:															 **/
+/******************************************************************************/
+
+#ifdef _2A03_DYNAREC
+
+// Runs the block starting at the decoded instruction,
+// returns the number of instructions it ran (0 if the interpreter has to)
+__inline int _2A03_run_block(s_2A03_decoded *decoded)
+{
+	register s_2A03_block *block = decoded->block;
+	register int length;
+
+	if(!_2A03_cpu->dynarec)
+	{
+		return 0;
+	}
+	if(!block || block->address != PC.W)
+	{
+		// Up to the end of the 4k window or the first patched byte
+		length = 0x1000 - (PC.W & 0xfff);
+		for(int i = 1; i < length; i++)
+		{
+			if(nes->o_control->is_patched(PC.W + i, 1))
+			{
+				length = i;
+				break;
+			}
+		}
+		block = _2A03_dynarec_translate(_2A03_cpu, PC.W,
+		                                &nes->o_cpu->PRGROM[decoded - _2A03_cpu->decoded],
+		                                length);
+		decoded->block = block;
+	}
+	return block->run ? block->run() : 0;
+}
+
+#endif
+
+/******************************************************************************/
+/** Running Ahead                                                            **/
+/**																			 **/
+/** Description:															 **/
+/******************************************************************************/
+
+// The PPU registers, the sprites DMA and the mappers registers
+// need the PPU to be up to date
+__inline __BOOL _2A03_is_ppu_access(__UINT_16 address, __BOOL write)
+{
+	if(address < 0x2000)
+	{
+		return FALSE;
+	}
+	if(address < 0x4000)
+	{
+		return TRUE;
+	}
+	if(address < 0x4020)
+	{
+		return address == 0x4014;
+	}
+	if(!nes->o_control->is_mapped(address))
+	{
+		return TRUE;
+	}
+	return write && !nes->o_control->is_write_mapped(address);
+}
+
+// Checks the address the instruction is about to access
+__inline __BOOL _2A03_needs_ppu(__UINT_8 instruction)
+{
+	register __UINT_16 address;
+	register __UINT_8 pointer = (__UINT_8) _2A03_operand;
+
+	switch(_2A03_instructionAddrMode[instruction])
+	{
+		case AB_:
+		case IDR:
+			address = _2A03_operand;
+			break;
+
+		case ABX:
+			address = _2A03_operand + X;
+			break;
+
+		case ABY:
+			address = _2A03_operand + Y;
+			break;
+
+		case PRE:
+			pointer += X;
+			address = NESRAM_ReadByte(pointer) | (NESRAM_ReadByte((__UINT_8) (pointer + 1)) << 8);
+			break;
+
+		case POS:
+			address = NESRAM_ReadByte(pointer) | (NESRAM_ReadByte((__UINT_8) (pointer + 1)) << 8);
+			address += Y;
+			break;
+
+		// Zero page, stack or no access at all
+		default:
+			return FALSE;
+	}
+	return _2A03_is_ppu_access(address, _2A03_memoryWrites[instruction]);
+}
 
 /******************************************************************************/
 /** status Flags                                                             **/
@@ -263,20 +555,148 @@ static __INT_32 iCurrentTime, iEndTime;
 	else if (0 == condition) S |= Z ;\
 }
 
+/******************************************************************************/
+/** Idle Loops                                                               **/
+/**																			 **/
+/** Description:															 **/
+/******************************************************************************/
+
+// Checks if executing the loop at address again would leave the cpu
+// in the same state, limit receives the time the read value may change
+__inline __BOOL _2A03_is_idle_loop(__UINT_16 address, int instructions, __INT_32 *limit)
+{
+	register __UINT_8 opcode;
+	register __UINT_8 value;
+	__UINT_16 target;
+	int length;
+
+	*limit = iEndTime;
+	if(address < 0x8000)
+	{
+		return FALSE;
+	}
+	opcode = NESPRGRAM_ReadByte(address);
+
+	// JMP *
+	if(instructions == 1)
+	{
+		return (opcode == 0x4c) && (NESPRGRAM_readWord(address + 1) == address);
+	}
+
+	switch(opcode)
+	{
+		// LDA/LDX/LDY/BIT zp
+		case 0xa5:
+		case 0xa6:
+		case 0xa4:
+		case 0x24:
+			target = NESPRGRAM_ReadByte(address + 1);
+			length = 2;
+			break;
+
+		// LDA/LDX/LDY/BIT abs
+		case 0xad:
+		case 0xae:
+		case 0xac:
+		case 0x2c:
+			target = NESPRGRAM_readWord(address + 1);
+			length = 3;
+			break;
+
+		default:
+			return FALSE;
+	}
+
+	// Followed by a branch back to it
+	if((NESPRGRAM_ReadByte(address + length) & 0x1f) != 0x10 ||
+	   (__UINT_16) (address + length + 2 + (INT_8) NESPRGRAM_ReadByte(address + length + 1)) != address)
+	{
+		return FALSE;
+	}
+
+	if(target < 0x2000)
+	{
+		value = NESRAM_ReadByte(target);
+	}
+	else if(target == 0x2002 && !_2A03_run_ahead)
+	{
+		value = nes->o_ppu->peek_status();
+		if(nes->o_ppu->status_stable_until() < *limit)
+		{
+			*limit = nes->o_ppu->status_stable_until();
+		}
+	}
+	else
+	{
+		return FALSE;
+	}
+
+	switch(opcode)
+	{
+		case 0xa5:
+		case 0xad:
+			return (A & 0xff) == value;
+		case 0xa6:
+		case 0xae:
+			return X == value;
+		case 0xa4:
+		case 0xac:
+			return Y == value;
+	}
+	return ((S & (N | V)) == (value & (N | V))) &&
+		   (((A & value) == 0) == ((S & Z) != 0));
+}
+
+// Spinning on $2002 or on a flag set by the nmi handler can't end
+// before the read value changes, so the iterations up to that time
+// (or the end of the time slice) are only accounted
+__inline void _2A03_skip_idle_loop(int *loop_pc, __INT_32 *loop_time)
+{
+	register int i;
+	__INT_32 limit;
+	__INT_32 cost;
+
+	for(i = 0; i < 2; i++)
+	{
+		if(PC.W == loop_pc[i])
+		{
+			if(_2A03_is_idle_loop(PC.W, i + 1, &limit))
+			{
+				cost = iCurrentTime - loop_time[i];
+				if(cost > 0 && (limit - 1) > iCurrentTime)
+				{
+					iCurrentTime += (((limit - 1) - iCurrentTime) / cost) * cost;
+				}
+			}
+			break;
+		}
+	}
+	loop_pc[1] = loop_pc[0];
+	loop_time[1] = loop_time[0];
+	loop_pc[0] = PC.W;
+	loop_time[0] = iCurrentTime;
+}
+
 /******************************************************************************/
 /** Addressing Modes                                                         **/
 /**																			 **/
 /** Description:															 **/
 /******************************************************************************/
 
-__inline __UINT_16 _2A03_immediate(void)
+// The operands were fetched with the opcode (see _2A03_fetch_operand ())
+
+#define _2A03_OPERAND(value) ((__UINT_8) (value))
+
+__inline __UINT_8 _2A03_immediate(void)
 {
-	return ++PC.W;
+	PC.W ++;
+	return (__UINT_8) _2A03_operand;
 }
 
 __inline __UINT_8 _2A03_zpAbsolute(void)
 {
-    return NESPRGRAM_ReadByte(++PC.W);
+	PC.W ++;
+	return (__UINT_8) _2A03_operand;
 }
 
 __inline __UINT_8 _2A03_zpIndexed(__UINT_8 _2A03_index)
@@ -285,14 +705,14 @@ __inline __UINT_8 _2A03_zpIndexed(__UINT_8 _2A03_index)
 	return (__UINT_8)(tmpAddress);
 }
 
-__inline __UINT_16 _2A03_absolute(void)
+template <int LABELS> __inline __UINT_16 _2A03_absolute(void)
 {
 	PC.W ++;
-	register __UINT_16 value = NESPRGRAM_readWord(PC.W);
+	register __UINT_16 value = _2A03_operand;
 
-	if (_2A03_labelHolder)
+	if (LABELS)
 	{
-		if ((int) value > 0x7fff)
+		if ((int) value > 0x7fff && nes->BankJMPList->is_new_site(PC.W - 1, SITE_DATA, value))
 		{
 		    nes->BankJMPList->insert_label(value, TYPE_DATA, TYPE_BYTE, 0, 0);
 	    }
@@ -305,19 +725,19 @@ __inline __UINT_16 _2A03_absolute(void)
 __inline __UINT_16 _2A03_absolute_write(void)
 {
 	PC.W ++;
-	register __UINT_16 value = NESPRGRAM_readWord(PC.W);
+	register __UINT_16 value = _2A03_operand;
 	PC.W ++;
 	return value;
 }
 
-__inline __UINT_16 _2A03_indexed(__UINT_8 _2A03_index)
+template <int LABELS> __inline __UINT_16 _2A03_indexed(__UINT_8 _2A03_index)
 {
 	PC.W ++;
-	register __UINT_16 value = NESPRGRAM_readWord(PC.W);
+	register __UINT_16 value = _2A03_operand;
 
-	if (_2A03_labelHolder)
+	if (LABELS)
 	{
-		if (value > 0x7fff)
+		if (value > 0x7fff && nes->BankJMPList->is_new_site(PC.W - 1, SITE_DATA, value))
 		{
 		    nes->BankJMPList->insert_label(value, TYPE_DATA, TYPE_BYTE, 0, 0);
 	    }
@@ -332,23 +752,24 @@ __inline __UINT_16 _2A03_indexed(__UINT_8 _2A03_index)
 __inline __UINT_16 _2A03_indexed_write(__UINT_8 _2A03_index)
 {
 	PC.W ++;
-	register __UINT_16 value = NESPRGRAM_readWord(PC.W);
+	register __UINT_16 value = _2A03_operand;
     value += _2A03_index;
 	PC.W ++;
 	return value;
 }
 
-__inline __UINT_16 _2A03_indexedCheckBounds(__UINT_8 _2A03_index)
+template <int LABELS> __inline __UINT_16 _2A03_indexedCheckBounds(__UINT_8 _2A03_index)
 {
 	register AWORD address;
 	register __UINT_8 bHighByte;
 
-	address.B.L = NESPRGRAM_ReadByte(++PC.W);
-	address.B.H = bHighByte = NESPRGRAM_ReadByte(++PC.W);
+	PC.W += 2;
+	address.W = _2A03_operand;
+	bHighByte = address.B.H;
 
-	if(_2A03_labelHolder)
+	if(LABELS)
 	{
-		if(address.W > 0x7fff)
+		if(address.W > 0x7fff && nes->BankJMPList->is_new_site(PC.W - 2, SITE_DATA, address.W))
 		{
 		    nes->BankJMPList->insert_label(address.W, TYPE_DATA, TYPE_BYTE, 0, 0);
 	    }
@@ -361,14 +782,14 @@ __inline __UINT_16 _2A03_indexedCheckBounds(__UINT_8 _2A03_index)
 	return address.W;
 }
 
-__inline __UINT_16 _2A03_indirect(void)
+template <int LABELS> __inline __UINT_16 _2A03_indirect(void)
 {
-	tmpAddress = _2A03_absolute();
+	tmpAddress = _2A03_absolute<LABELS>();
 	tmpByte = NESCTL_ReadByte(tmpAddress);
 	tmpAddress = (tmpAddress & 0xff00) | ((tmpAddress + 1) & 0xff);
     register __UINT_16 value = (tmpByte | (NESCTL_ReadByte(tmpAddress) << 8));
     
-	if (_2A03_labelHolder)
+	if (LABELS)
 	{
 		if ((int) value > 0x7fff)
 		{
@@ -407,10 +828,10 @@ __inline __UINT_16 _2A03_postIndexedCheckBounds(void)
 	if (condition) \
 	{ \
 		tmpWord.W = PC.W + 2; \
-		tmpByte = NESPRGRAM_ReadByte(_2A03_immediate()); \
+		tmpByte = _2A03_immediate(); \
 		tmpInt = PC.W + (INT_8)(tmpByte) + 1; \
 		iCurrentTime += ((tmpInt >> 8) != (tmpWord.B.H)) ? (_2A03_FIX_CYCLES(2)) : (_2A03_FIX_CYCLES(1)); \
-	    if (_2A03_labelHolder) \
+	    if (LABELS && nes->BankJMPList->is_new_site(PC.W - 1, SITE_BRANCH, tmpInt)) \
 	    { \
 		    nes->BankJMPList->insert_label(tmpInt, TYPE_CODE, TYPE_RELCODE, 0, 0); \
 	    } \
@@ -418,11 +839,14 @@ __inline __UINT_16 _2A03_postIndexedCheckBounds(void)
 	} \
 	else \
 	{ \
-	    if (_2A03_labelHolder) \
+	    if (LABELS) \
 	    { \
-		    tmpByte = NESPRGRAM_ReadByte(PC.W + 1); \
+		    tmpByte = (__UINT_8) _2A03_operand; \
 		    tmpInt = (PC.W + 1) + (INT_8)(tmpByte) + 1; \
-		    nes->BankJMPList->insert_label(tmpInt, TYPE_CODE, TYPE_RELCODE, 0, 0); \
+		    if (nes->BankJMPList->is_new_site(PC.W, SITE_BRANCH, tmpInt)) \
+		    { \
+		        nes->BankJMPList->insert_label(tmpInt, TYPE_CODE, TYPE_RELCODE, 0, 0); \
+		    } \
 	    } \
 	    PC.W += 2; \
     } \
@@ -643,6 +1067,7 @@ void _2A03_reset(void)
 
 	_2A03_IRQLine = _2A03_NMIRequested = _2A03_IRQRequested = FALSE;
 	_2A03_unfinishedOp = FALSE;
+	_2A03_events = TRUE;
 
 	NMIAddr = NESPRGRAM_readWord (0xfffa);
 	if(_2A03_instructionDumper) nes->general_log.f_write("sws", "NMI Vector: ", NMIAddr, "\r\n");
@@ -650,6 +1075,12 @@ void _2A03_reset(void)
 	if(_2A03_instructionDumper) nes->general_log.f_write("sws", "Reset Vector: ", resetAddr, "\r\n");
 	IRQAddr = NESPRGRAM_readWord (0xfffe);
 	if(_2A03_instructionDumper) nes->general_log.f_write("sws", "IRQ Vector: ", IRQAddr, "\r\n");
+	if(_2A03_instructionLog)
+	{
+		nes->instruction_trace.add_marker(TRACE_NMI_VECTOR, NMIAddr);
+		nes->instruction_trace.add_marker(TRACE_RESET_VECTOR, resetAddr);
+		nes->instruction_trace.add_marker(TRACE_IRQ_VECTOR, IRQAddr);
+	}
  
 	PC.W = resetAddr;
 
@@ -661,6 +1092,9 @@ void _2A03_reset(void)
 
 	_2A03_cycleCounts = _2A03_PPUCycleCounts;
 	_2A03_accessCycles = _2A03_PPUAccessCycles;
+
+	memset(_2A03_cpu->decoded, 0, _2A03_cpu->decoded_size * sizeof(s_2A03_decoded));
+	_2A03_dynarec_flush(_2A03_cpu);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -671,16 +1105,19 @@ void _2A03_reset(void)
 void _2A03_request_nmi(void)
 {
     _2A03_NMIRequested = TRUE;
+    _2A03_events = TRUE;
 }
 
 void _2A03_request_secondary_nmi (void)
 {
     _2A03_NMISecondRequested = TRUE;
+    _2A03_events = TRUE;
 }
 
 void _2A03_request_irq(void)
 {
     _2A03_IRQRequested = TRUE;
+    _2A03_events = TRUE;
 }
 
 void _2A03_NMI (void)
@@ -700,6 +1137,7 @@ void _2A03_NMI (void)
 void _2A03_set_irq_line(__BOOL status)
 {
 	_2A03_IRQLine = status;
+	_2A03_events = TRUE;
 }
 
 __BOOL _2A03_getIRQLine(void)
@@ -736,12 +1174,17 @@ void _2A03_run(__INT_32 cycles)
 	_2A03_run();
 }
 
-void _2A03_run(void)
+// Instantiated once per combination of the features which cost something
+// per instruction (see _2A03_select_run ())
+template <int LABELS, int LOG> static void _2A03_run_mode(void)
 {
     int old_pc;
     int zp_addr;
     int return_address;
     register __UINT_16 value;
+    // Last 2 instructions (to spot the idle loops)
+    int loop_pc[2] = { -1, -1 };
+    __INT_32 loop_time[2] = { 0, 0 };
 	if(iCurrentTime == iEndTime)
     {
         return;
@@ -754,39 +1197,98 @@ void _2A03_run(void)
 
 	while(iCurrentTime < iEndTime)
 	{
-		if(!_2A03_unfinishedOp)
+		// Without tracing, straight code runs from one event to the next:
+		// the interrupts state only changes through the requests,
+		// the I flag or a new time slice
+		if(!_2A03_unfinishedOp && (LABELS || LOG || _2A03_events))
 		{
+			_2A03_events = FALSE;
 			if(_2A03_NMIRequested)
             {
                 _2A03_NMI();
                 _2A03_NMIRequested = FALSE;
+                _2A03_events = TRUE;
+                loop_pc[0] = loop_pc[1] = -1;
                 continue;
             }
 			if(_2A03_NMISecondRequested)
             {
                 _2A03_NMIRequested = TRUE;
                 _2A03_NMISecondRequested = FALSE;
+                _2A03_events = TRUE;
             }
 			if(_2A03_IRQRequested || (_2A03_IRQLine && !(S & I)))
 			{
 				_2A03_IRQ();
 				_2A03_IRQRequested = FALSE;
+				_2A03_events = TRUE;
+				loop_pc[0] = loop_pc[1] = -1;
 				continue;
 			}
 		}
 
-		register __UINT_8 _2A03_instruction = NESCTL_ReadByte (PC.W);
-		if(_2A03_instructionLog && !_2A03_unfinishedOp)
+		if(!LABELS && !LOG && !_2A03_unfinishedOp)
+		{
+			_2A03_skip_idle_loop(loop_pc, loop_time);
+		}
+
+		register __UINT_8 _2A03_instruction;
+		register __UINT_32 _2A03_cycles;
+		register __BOOL _2A03_access;
+		register s_2A03_decoded *decoded = _2A03_decode (PC.W);
+
+		if(decoded)
+		{
+			_2A03_instruction = decoded->opcode;
+			_2A03_cycles = decoded->cycles;
+			_2A03_access = decoded->has_access;
+			_2A03_operand = decoded->operand;
+		}
+		else
+		{
+			_2A03_instruction = NESCTL_ReadByte (PC.W);
+			_2A03_cycles = _2A03_cycleCounts [_2A03_instruction];
+			_2A03_access = _2A03_accessCycles [_2A03_instruction] ? TRUE : FALSE;
+			_2A03_operand = _2A03_fetch_operand (PC.W, _2A03_instruction);
+		}
+#ifdef _2A03_DYNAREC
+		// Straight code doesn't need the per-instruction events
+		// (the blocks stop before the I/O accesses and at iEndTime)
+		if(!LABELS && !LOG && decoded && !_2A03_unfinishedOp && !_2A03_events)
+		{
+			register int ran = _2A03_run_block(decoded);
+
+			if(ran)
+			{
+				if(ran > 1)
+				{
+					loop_pc[0] = loop_pc[1] = -1;
+				}
+				continue;
+			}
+		}
+#endif
+		// Let the PPU catch up before the access
+		if(_2A03_run_ahead && _2A03_needs_ppu(_2A03_instruction))
+		{
+			_2A03_run_ahead = FALSE;
+			return;
+		}
+		if(LABELS && !_2A03_unfinishedOp)
+		{
+		    _2A03_log_code (PC.W, _2A03_instruction, decoded);
+        }
+		if(LOG && !_2A03_unfinishedOp)
 		{
-		    _2A03_disassembleInstruction (PC.W);
+		    _2A03_trace_instruction (PC.W);
         }
 		
 		if(!_2A03_unfinishedOp)
 		{
-			iCurrentTime += _2A03_cycleCounts [_2A03_instruction];
+			iCurrentTime += _2A03_cycles;
 		}
 
-		if((iCurrentTime > iEndTime) && _2A03_accessCycles[_2A03_instruction])
+		if((iCurrentTime > iEndTime) && _2A03_access)
 		{
 			_2A03_unfinishedOp = TRUE;
 			return;
@@ -800,7 +1302,7 @@ void _2A03_run(void)
 		{
 			//LDA - load accumulator with memory//
 			case 0xa9:
-			    _2A03_LOAD(A, NESPRGRAM_ReadByte, _2A03_immediate());
+			    _2A03_LOAD(A, _2A03_OPERAND, _2A03_immediate());
 			    break;
 
 			case 0xa5:
@@ -812,12 +1314,12 @@ void _2A03_run(void)
 			    break;
 
 			case 0xad:
-			    _2A03_LOAD(A, NESCTL_ReadByte, _2A03_absolute());
+			    _2A03_LOAD(A, NESCTL_ReadData, _2A03_absolute<LABELS>());
 			    break;
 
 			case 0xbd:
                 // x, x / x + 1, x
-                if((base_addr + 1) == (int) NESPRGRAM_readWord(PC.W + 1))
+                if((base_addr + 1) == (int) _2A03_operand)
                 {
                     // Next part of the address
                     jump_addr = NESPRGRAM_readWord(idx_addr);
@@ -826,7 +1328,7 @@ void _2A03_run(void)
 	            else
 	            {
                     // Variant x, x / x, x + 1
-                    if(base_addr == (int) NESPRGRAM_readWord(PC.W + 1) &&
+                    if(base_addr == (int) _2A03_operand &&
                        ((idx_addr + 1) == base_addr + X) &&
                        (X == last_x + 1))
                     {
@@ -836,17 +1338,17 @@ void _2A03_run(void)
                     }
                     else
                     {
-	                    base_addr = NESPRGRAM_readWord(PC.W + 1);
+	                    base_addr = _2A03_operand;
 			            idx_addr = base_addr + X;
 			            last_x = X;
                     }
                 }
-			    _2A03_LOAD (A, NESCTL_ReadByte, _2A03_indexedCheckBounds(X));
+			    _2A03_LOAD (A, NESCTL_ReadData, _2A03_indexedCheckBounds<LABELS>(X));
 			    break;
 
 			case 0xb9:
                 // x, y / x + 1, y
-                if((base_addr + 1) == (int) NESPRGRAM_readWord(PC.W + 1))
+                if((base_addr + 1) == (int) _2A03_operand)
                 {
                     // Next part of the address
                     jump_addr = NESPRGRAM_readWord(idx_addr);
@@ -855,7 +1357,7 @@ void _2A03_run(void)
 	            else
 	            {
                     // Variant x, y / x, y + 1
-                    if(base_addr == (int) NESPRGRAM_readWord(PC.W + 1) &&
+                    if(base_addr == (int) _2A03_operand &&
                        ((idx_addr + 1) == base_addr + Y) &&
                        (Y == last_y + 1))
                     {
@@ -865,22 +1367,22 @@ void _2A03_run(void)
                     }
                     else
                     {
-	                    base_addr = NESPRGRAM_readWord(PC.W + 1);
+	                    base_addr = _2A03_operand;
 			            idx_addr = base_addr + Y;
 			            last_y = Y;
                     }
                 }
-			    _2A03_LOAD (A, NESCTL_ReadByte, _2A03_indexedCheckBounds(Y));
+			    _2A03_LOAD (A, NESCTL_ReadData, _2A03_indexedCheckBounds<LABELS>(Y));
 			    break;
 
 			case 0xa1:
-			    _2A03_LOAD (A, NESCTL_ReadByte, _2A03_preIndexed());
+			    _2A03_LOAD (A, NESCTL_ReadIndirectData, _2A03_preIndexed());
 			    break;
 
 			case 0xb1:
 			    // ZP post indexed
                 // x, y / x + 1 ,y
-                zp_addr = NESPRGRAM_ReadByte(PC.W + 1);
+                zp_addr = (__UINT_8) _2A03_operand;
                 zp_addr = NESPRGRAM_readWord(zp_addr);
                 if((base_addr + 1) == (int) zp_addr)
                 {
@@ -908,7 +1410,7 @@ void _2A03_run(void)
 			            last_y = Y;
                     }
                 }
-			    _2A03_LOAD(A, NESCTL_ReadByte, _2A03_postIndexedCheckBounds());
+			    _2A03_LOAD(A, NESCTL_ReadIndirectData, _2A03_postIndexedCheckBounds());
 			    break;
 
 			//STA - Store accumulator in memory//
@@ -942,7 +1444,7 @@ void _2A03_run(void)
 
 			//ADC - Add memory to accumulator with carry//
 			case 0x69:
-				_2A03_ADC(NESPRGRAM_ReadByte, _2A03_immediate());
+				_2A03_ADC(_2A03_OPERAND, _2A03_immediate());
 				break;
 
 			case 0x65:
@@ -954,28 +1456,28 @@ void _2A03_run(void)
 				break;
 
 			case 0x6d:
-				_2A03_ADC(NESCTL_ReadByte, _2A03_absolute());
+				_2A03_ADC(NESCTL_ReadData, _2A03_absolute<LABELS>());
 				break;
 
 			case 0x7d:
-				_2A03_ADC(NESCTL_ReadByte, _2A03_indexedCheckBounds(X));
+				_2A03_ADC(NESCTL_ReadData, _2A03_indexedCheckBounds<LABELS>(X));
 				break;
 
 			case 0x79:
-				_2A03_ADC(NESCTL_ReadByte, _2A03_indexedCheckBounds(Y));
+				_2A03_ADC(NESCTL_ReadData, _2A03_indexedCheckBounds<LABELS>(Y));
 				break;
 
 			case 0x61:
-				_2A03_ADC(NESCTL_ReadByte, _2A03_preIndexed());
+				_2A03_ADC(NESCTL_ReadIndirectData, _2A03_preIndexed());
 				break;
 
 			case 0x71:
-				_2A03_ADC(NESCTL_ReadByte, _2A03_postIndexedCheckBounds());
+				_2A03_ADC(NESCTL_ReadIndirectData, _2A03_postIndexedCheckBounds());
 				break;
 
 			//AND - AND memory with accumulator//
 			case 0x29:
-				_2A03_AND(NESPRGRAM_ReadByte, _2A03_immediate());
+				_2A03_AND(_2A03_OPERAND, _2A03_immediate());
 				break;
 
 			case 0x25:
@@ -987,23 +1489,23 @@ void _2A03_run(void)
 				break;
 
 			case 0x2d:
-				_2A03_AND(NESCTL_ReadByte, _2A03_absolute());
+				_2A03_AND(NESCTL_ReadData, _2A03_absolute<LABELS>());
 				break;
 
 			case 0x3d:
-				_2A03_AND(NESCTL_ReadByte, _2A03_indexedCheckBounds(X));
+				_2A03_AND(NESCTL_ReadData, _2A03_indexedCheckBounds<LABELS>(X));
 				break;
 
 			case 0x39:
-				_2A03_AND(NESCTL_ReadByte, _2A03_indexedCheckBounds(Y));
+				_2A03_AND(NESCTL_ReadData, _2A03_indexedCheckBounds<LABELS>(Y));
 				break;
 
 			case 0x21:
-				_2A03_AND(NESCTL_ReadByte, _2A03_preIndexed());
+				_2A03_AND(NESCTL_ReadIndirectData, _2A03_preIndexed());
 				break;
 
 			case 0x31:
-				_2A03_AND(NESCTL_ReadByte, _2A03_postIndexedCheckBounds());
+				_2A03_AND(NESCTL_ReadIndirectData, _2A03_postIndexedCheckBounds());
 				break; 
 
 			//ASL - Shift left one bit (memory or accumulator)//
@@ -1020,11 +1522,11 @@ void _2A03_run(void)
 				break;
 
 			case 0x0e:
-				_2A03_ASL(NESCTL_ReadByte, NESCTL_write_byte, _2A03_absolute());
+				_2A03_ASL(NESCTL_ReadData, NESCTL_write_byte, _2A03_absolute<LABELS>());
 				break;
 
 			case 0x1e:
-				_2A03_ASL(NESCTL_ReadByte, NESCTL_write_byte, _2A03_indexed(X));
+				_2A03_ASL(NESCTL_ReadData, NESCTL_write_byte, _2A03_indexed<LABELS>(X));
 				break;
 			
 			//BCC - Branch on carry clear//
@@ -1048,7 +1550,7 @@ void _2A03_run(void)
 				break;
 
 			case 0x2c:
-				_2A03_BIT(NESCTL_ReadByte, _2A03_absolute ());
+				_2A03_BIT(NESCTL_ReadData, _2A03_absolute<LABELS> ());
 				break;
 
 			//BMI - Branch on result minus//
@@ -1102,7 +1604,7 @@ void _2A03_run(void)
 
 			//CMP - Compare memory and accumulator//
 			case 0xc9:
-				_2A03_COMPARE(A, NESPRGRAM_ReadByte, _2A03_immediate());
+				_2A03_COMPARE(A, _2A03_OPERAND, _2A03_immediate());
 				break;
 
 			case 0xc5:
@@ -1114,28 +1616,28 @@ void _2A03_run(void)
 				break;
 
 			case 0xcd:
-				_2A03_COMPARE(A, NESCTL_ReadByte, _2A03_absolute());
+				_2A03_COMPARE(A, NESCTL_ReadData, _2A03_absolute<LABELS>());
 				break;
 
 			case 0xdd:
-				_2A03_COMPARE(A, NESCTL_ReadByte, _2A03_indexedCheckBounds(X));
+				_2A03_COMPARE(A, NESCTL_ReadData, _2A03_indexedCheckBounds<LABELS>(X));
 				break;
 
 			case 0xd9:
-				_2A03_COMPARE(A, NESCTL_ReadByte, _2A03_indexedCheckBounds(Y));
+				_2A03_COMPARE(A, NESCTL_ReadData, _2A03_indexedCheckBounds<LABELS>(Y));
 				break;
 
 			case 0xc1:
-				_2A03_COMPARE(A, NESCTL_ReadByte, _2A03_preIndexed());
+				_2A03_COMPARE(A, NESCTL_ReadIndirectData, _2A03_preIndexed());
 				break;
 
 			case 0xd1:
-				_2A03_COMPARE(A, NESCTL_ReadByte, _2A03_postIndexedCheckBounds());
+				_2A03_COMPARE(A, NESCTL_ReadIndirectData, _2A03_postIndexedCheckBounds());
 				break; 
 
 			//CPX - Compare memory and index X//
 			case 0xe0:
-				_2A03_COMPARE(X, NESPRGRAM_ReadByte, _2A03_immediate());
+				_2A03_COMPARE(X, _2A03_OPERAND, _2A03_immediate());
 				break;
 
 			case 0xe4:
@@ -1143,12 +1645,12 @@ void _2A03_run(void)
 				break;
 
 			case 0xec:
-				_2A03_COMPARE(X, NESCTL_ReadByte, _2A03_absolute());
+				_2A03_COMPARE(X, NESCTL_ReadData, _2A03_absolute<LABELS>());
 				break;
 
 			//CPY - Compare memory and index Y//
 			case 0xc0: 
-				_2A03_COMPARE(Y, NESPRGRAM_ReadByte, _2A03_immediate ());
+				_2A03_COMPARE(Y, _2A03_OPERAND, _2A03_immediate ());
 				break;
 
 			case 0xc4:
@@ -1156,7 +1658,7 @@ void _2A03_run(void)
 				break;
 
 			case 0xcc: 
-				_2A03_COMPARE(Y, NESCTL_ReadByte, _2A03_absolute ()); 
+				_2A03_COMPARE(Y, NESCTL_ReadData, _2A03_absolute<LABELS> ()); 
 				break;
 
 			//DEC - Decrement memory by one//
@@ -1169,11 +1671,11 @@ void _2A03_run(void)
 				break;
 
 			case 0xce: 
-				_2A03_DEC(NESCTL_ReadByte, NESCTL_write_byte, _2A03_absolute()); 
+				_2A03_DEC(NESCTL_ReadData, NESCTL_write_byte, _2A03_absolute<LABELS>()); 
 				break;
 
 			case 0xde: 
-				_2A03_DEC(NESCTL_ReadByte, NESCTL_write_byte, _2A03_indexed(X)); 
+				_2A03_DEC(NESCTL_ReadData, NESCTL_write_byte, _2A03_indexed<LABELS>(X)); 
 				break;
 
 			//DEX - Decrement index X by one//
@@ -1192,7 +1694,7 @@ void _2A03_run(void)
 
 			//EOR - Exclusive OR memory with accumulator//
 			case 0x49: 
-				_2A03_EOR(NESPRGRAM_ReadByte, _2A03_immediate()); 
+				_2A03_EOR(_2A03_OPERAND, _2A03_immediate()); 
 				break;
 
 			case 0x45: 
@@ -1204,23 +1706,23 @@ void _2A03_run(void)
 				break;
 
 			case 0x4d: 
-				_2A03_EOR(NESCTL_ReadByte, _2A03_absolute()); 
+				_2A03_EOR(NESCTL_ReadData, _2A03_absolute<LABELS>()); 
 				break;
 
 			case 0x5d: 
-				_2A03_EOR(NESCTL_ReadByte, _2A03_indexedCheckBounds(X)); 
+				_2A03_EOR(NESCTL_ReadData, _2A03_indexedCheckBounds<LABELS>(X)); 
 				break;
 
 			case 0x59: 
-				_2A03_EOR(NESCTL_ReadByte, _2A03_indexedCheckBounds(Y)); 
+				_2A03_EOR(NESCTL_ReadData, _2A03_indexedCheckBounds<LABELS>(Y)); 
 				break;
 
 			case 0x41: 
-				_2A03_EOR(NESCTL_ReadByte, _2A03_preIndexed()); 
+				_2A03_EOR(NESCTL_ReadIndirectData, _2A03_preIndexed()); 
 				break;
 
 			case 0x51: 
-				_2A03_EOR(NESCTL_ReadByte, _2A03_postIndexedCheckBounds()); 
+				_2A03_EOR(NESCTL_ReadIndirectData, _2A03_postIndexedCheckBounds()); 
 				break;
 
 			//INC - Increment memory by one//
@@ -1233,11 +1735,11 @@ void _2A03_run(void)
 				break;
 
 			case 0xee: 
-				_2A03_INC(NESCTL_ReadByte, NESCTL_write_byte, _2A03_absolute()); 
+				_2A03_INC(NESCTL_ReadData, NESCTL_write_byte, _2A03_absolute<LABELS>()); 
 				break;
 
 			case 0xfe: 
-				_2A03_INC(NESCTL_ReadByte, NESCTL_write_byte, _2A03_indexed(X)); 
+				_2A03_INC(NESCTL_ReadData, NESCTL_write_byte, _2A03_indexed<LABELS>(X)); 
 				break;
 
 			//INX - Increment index X by one//
@@ -1258,15 +1760,18 @@ void _2A03_run(void)
 			case 0x4c: 
 		        old_pc = PC.W;
 		        return_address = PC.W + 3;
-			    PC.W = _2A03_absolute();
-				if(_2A03_labelHolder)
+			    PC.W = _2A03_absolute<LABELS>();
+				if(LABELS)
 				{
-					if(PC.W > 0x7fff)
+					if(PC.W > 0x7fff && nes->BankJMPList->is_new_site(old_pc, SITE_JUMP, PC.W))
 					{
 						nes->BankJMPList->insert_label(PC.W, TYPE_CODE, TYPE_CODE, 0, 0, nes->o_mapper->get_real_prg_bank_number(old_pc));
                     }
                     // Terminate it
-                    nes->BankJMPList->insert_label(return_address, TYPE_DATA, TYPE_BYTE, 0, 0);
+                    if(nes->BankJMPList->is_new_site(old_pc, SITE_END, return_address))
+                    {
+                        nes->BankJMPList->insert_label(return_address, TYPE_DATA, TYPE_BYTE, 0, 0);
+                    }
                 }
                 last_x = 0x12345678;
                 last_y = 0x12345678;
@@ -1276,8 +1781,8 @@ void _2A03_run(void)
 			case 0x6c:
 		        old_pc = PC.W;
 		        return_address = PC.W + 3;
-	            value = NESPRGRAM_readWord(PC.W + 1);
-				if(_2A03_labelHolder)
+	            value = _2A03_operand;
+				if(LABELS)
 				{
                     if(NESPRGRAM_readWord(value) == jump_addr)
                     {
@@ -1285,7 +1790,7 @@ void _2A03_run(void)
                         while((idx_addr >= base_addr))
                         {
                             // Fill the previous entries of the table
-                            nes->BankJMPList->insert_label_bank(nes->o_mapper->get_real_prg_bank_number(NESPRGRAM_readWord(value)),
+                            nes->BankJMPList->queue_label_bank(nes->o_mapper->get_real_prg_bank_number(NESPRGRAM_readWord(value)),
                                                                 idx_addr, TYPE_DATA, TYPE_WORD, 1, base_addr,
 																nes->BankJMPList->get_bank_alias(nes->o_mapper->get_real_prg_bank_number(old_pc), old_pc),
 																nes->o_cpu->get_rom_offset(value), nes->o_mapper->get_real_prg_bank_number(old_pc));
@@ -1297,17 +1802,21 @@ void _2A03_run(void)
                     }
                 }
 		        // This would be a pointer (or a pointer table)
-				if(_2A03_labelHolder)
+				if(LABELS)
 				{
-                    if((int) value > 0x7fff)
+                    if((int) value > 0x7fff && nes->BankJMPList->is_new_site(old_pc, SITE_POINTER, value))
                     {
                         nes->BankJMPList->insert_label(value, TYPE_DATA, TYPE_WORD, 0, 0, nes->o_mapper->get_real_prg_bank_number(old_pc));
                     }
                 }
 
-			    PC.W = _2A03_indirect();
-				if(_2A03_labelHolder)
+			    PC.W = _2A03_indirect<LABELS>();
+				if(LABELS)
 				{
+					// Pointer and reached code
+					_2A03_log_prg(value, CDL_PRG_DATA);
+					_2A03_log_prg((value & 0xff00) | ((value + 1) & 0xff), CDL_PRG_DATA);
+					_2A03_log_prg(PC.W, CDL_PRG_INDIRECT_CODE);
 					// Dest address
                     if(PC.W > 0x7fff)
                     {
@@ -1317,7 +1826,10 @@ void _2A03_run(void)
                     // Note: if a table word pointers is right after
                     // the jmp the label is already added above
                     // (no overwriting occurs).
-                    nes->BankJMPList->insert_label(return_address, TYPE_DATA, TYPE_BYTE, 0, 0);
+                    if(nes->BankJMPList->is_new_site(old_pc, SITE_END, return_address))
+                    {
+                        nes->BankJMPList->insert_label(return_address, TYPE_DATA, TYPE_BYTE, 0, 0);
+                    }
                 }
                 last_x = 0x12345678;
                 last_y = 0x12345678;
@@ -1328,10 +1840,10 @@ void _2A03_run(void)
 		        old_pc = PC.W;
 			    _2A03_PUSH((PC.W + 2) >> 8);
 			    _2A03_PUSH((__UINT_8)(PC.W) + 2);
-			    PC.W = _2A03_absolute();
-				if(_2A03_labelHolder)
+			    PC.W = _2A03_absolute<LABELS>();
+				if(LABELS)
 				{
-					if(PC.W > 0x7fff)
+					if(PC.W > 0x7fff && nes->BankJMPList->is_new_site(old_pc, SITE_JUMP, PC.W))
 					{
 						nes->BankJMPList->insert_label(PC.W, TYPE_CODE, TYPE_CODE, 0, 0, nes->o_mapper->get_real_prg_bank_number(old_pc));
                     }
@@ -1342,7 +1854,7 @@ void _2A03_run(void)
 
 			//LDX - load index X with memory//
 			case 0xa2: 
-				_2A03_LOAD(X, NESPRGRAM_ReadByte, _2A03_immediate()); 
+				_2A03_LOAD(X, _2A03_OPERAND, _2A03_immediate()); 
 				break;
 
 			case 0xa6: 
@@ -1354,16 +1866,16 @@ void _2A03_run(void)
 				break;
 
 			case 0xae: 
-				_2A03_LOAD(X, NESCTL_ReadByte, _2A03_absolute()); 
+				_2A03_LOAD(X, NESCTL_ReadData, _2A03_absolute<LABELS>()); 
 				break;
 
 			case 0xbe: 
-				_2A03_LOAD(X, NESCTL_ReadByte, _2A03_indexedCheckBounds(Y)); 
+				_2A03_LOAD(X, NESCTL_ReadData, _2A03_indexedCheckBounds<LABELS>(Y)); 
 				break;
 
 			//LDY - load index Y with memory//
 			case 0xa0: 
-				_2A03_LOAD(Y, NESPRGRAM_ReadByte, _2A03_immediate()); 
+				_2A03_LOAD(Y, _2A03_OPERAND, _2A03_immediate()); 
 				break;
 
 			case 0xa4: 
@@ -1375,11 +1887,11 @@ void _2A03_run(void)
 				break;
 
 			case 0xac: 
-				_2A03_LOAD(Y, NESCTL_ReadByte, _2A03_absolute()); 
+				_2A03_LOAD(Y, NESCTL_ReadData, _2A03_absolute<LABELS>()); 
 				break;
 
 			case 0xbc: 
-				_2A03_LOAD(Y, NESCTL_ReadByte, _2A03_indexedCheckBounds(X)); 
+				_2A03_LOAD(Y, NESCTL_ReadData, _2A03_indexedCheckBounds<LABELS>(X)); 
 				break;
 
 			//LSR - Shift right one bit (memory or accumulator)//
@@ -1396,11 +1908,11 @@ void _2A03_run(void)
 				break;
 
 			case 0x4e: 
-				_2A03_LSR(NESCTL_ReadByte, NESCTL_write_byte, _2A03_absolute()); 
+				_2A03_LSR(NESCTL_ReadData, NESCTL_write_byte, _2A03_absolute<LABELS>()); 
 				break;
 
 			case 0x5e: 
-				_2A03_LSR(NESCTL_ReadByte, NESCTL_write_byte, _2A03_indexed(X)); 
+				_2A03_LSR(NESCTL_ReadData, NESCTL_write_byte, _2A03_indexed<LABELS>(X)); 
 				break;
 
 			//NOP - No operation//
@@ -1409,7 +1921,7 @@ void _2A03_run(void)
 			
 			//ORA - OR memory with accumulator//
 			case 0x09: 
-				_2A03_ORA(NESPRGRAM_ReadByte, _2A03_immediate()); 
+				_2A03_ORA(_2A03_OPERAND, _2A03_immediate()); 
 				break;
 
 			case 0x05: 
@@ -1421,23 +1933,23 @@ void _2A03_run(void)
 				break;
 
 			case 0x0d: 
-				_2A03_ORA(NESCTL_ReadByte, _2A03_absolute()); 
+				_2A03_ORA(NESCTL_ReadData, _2A03_absolute<LABELS>()); 
 				break;
 
 			case 0x1d: 
-				_2A03_ORA(NESCTL_ReadByte, _2A03_indexedCheckBounds(X)); 
+				_2A03_ORA(NESCTL_ReadData, _2A03_indexedCheckBounds<LABELS>(X)); 
 				break;
 
 			case 0x19: 
-				_2A03_ORA(NESCTL_ReadByte, _2A03_indexedCheckBounds(Y)); 
+				_2A03_ORA(NESCTL_ReadData, _2A03_indexedCheckBounds<LABELS>(Y)); 
 				break;
 
 			case 0x01: 
-				_2A03_ORA(NESCTL_ReadByte, _2A03_preIndexed()); 
+				_2A03_ORA(NESCTL_ReadIndirectData, _2A03_preIndexed()); 
 
 				break;
 			case 0x11: 
-				_2A03_ORA(NESCTL_ReadByte, _2A03_postIndexedCheckBounds()); 
+				_2A03_ORA(NESCTL_ReadIndirectData, _2A03_postIndexedCheckBounds()); 
 				break;
 
 			//PHA - Push accumulator on stack//
@@ -1470,6 +1982,7 @@ void _2A03_run(void)
 				_2A03_POP(S); 
 				S &= ~FLAG_B; 
 				S |= BIT_5; 
+				_2A03_events = TRUE;
 				break;
 
 			//ROL - Rotate one bit left//
@@ -1486,11 +1999,11 @@ void _2A03_run(void)
 				break;
 
 			case 0x2e: 
-				_2A03_ROL(NESCTL_ReadByte, NESCTL_write_byte, _2A03_absolute()); 
+				_2A03_ROL(NESCTL_ReadData, NESCTL_write_byte, _2A03_absolute<LABELS>()); 
 				break;
 
 			case 0x3e: 
-				_2A03_ROL(NESCTL_ReadByte, NESCTL_write_byte, _2A03_indexed(X)); 
+				_2A03_ROL(NESCTL_ReadData, NESCTL_write_byte, _2A03_indexed<LABELS>(X)); 
 				break;
 
 			//ROR - Rotate one bit right//
@@ -1507,20 +2020,21 @@ void _2A03_run(void)
 				break;
 
 			case 0x6e: 
-				_2A03_ROR(NESCTL_ReadByte, NESCTL_write_byte, _2A03_absolute()); 
+				_2A03_ROR(NESCTL_ReadData, NESCTL_write_byte, _2A03_absolute<LABELS>()); 
 				break;
 
 			case 0x7e: 
-				_2A03_ROR(NESCTL_ReadByte, NESCTL_write_byte, _2A03_indexed(X)); 
+				_2A03_ROR(NESCTL_ReadData, NESCTL_write_byte, _2A03_indexed<LABELS>(X)); 
 				break;
 
 			//RTI - Return from interrupt//
 			case 0x40:
                 last_x = 0x12345678;
                 last_y = 0x12345678;
-				if(_2A03_labelHolder)
+                _2A03_events = TRUE;
+				if(LABELS)
 				{
-					if(PC.W > 0x7fff)
+					if(PC.W > 0x7fff && nes->BankJMPList->is_new_site(PC.W, SITE_END, PC.W + 1))
 					{
 						nes->BankJMPList->insert_label(PC.W + 1, TYPE_DATA, TYPE_BYTE, 0, 0);
 					}
@@ -1536,9 +2050,9 @@ void _2A03_run(void)
                 last_x = 0x12345678;
                 last_y = 0x12345678;
  
- 				if(_2A03_labelHolder)
+ 				if(LABELS)
 				{
-					if(PC.W > 0x7fff)
+					if(PC.W > 0x7fff && nes->BankJMPList->is_new_site(PC.W, SITE_END, PC.W + 1))
 					{
 						nes->BankJMPList->insert_label(PC.W + 1, TYPE_DATA, TYPE_BYTE, 0, 0);
 					}
@@ -1550,7 +2064,7 @@ void _2A03_run(void)
 
 			//SBC - Subtract memory from accumulator with borrow//
 			case 0xe9: 
-				_2A03_SBC(NESPRGRAM_ReadByte, _2A03_immediate()); 
+				_2A03_SBC(_2A03_OPERAND, _2A03_immediate()); 
 				break;
 
 			case 0xe5: 
@@ -1562,23 +2076,23 @@ void _2A03_run(void)
 				break;
 
 			case 0xed: 
-				_2A03_SBC(NESCTL_ReadByte, _2A03_absolute()); 
+				_2A03_SBC(NESCTL_ReadData, _2A03_absolute<LABELS>()); 
 				break;
 
 			case 0xfd: 
-				_2A03_SBC(NESCTL_ReadByte, _2A03_indexedCheckBounds(X)); 
+				_2A03_SBC(NESCTL_ReadData, _2A03_indexedCheckBounds<LABELS>(X)); 
 				break;
 
 			case 0xf9: 
-				_2A03_SBC(NESCTL_ReadByte, _2A03_indexedCheckBounds(Y)); 
+				_2A03_SBC(NESCTL_ReadData, _2A03_indexedCheckBounds<LABELS>(Y)); 
 				break;
 
 			case 0xe1: 
-				_2A03_SBC(NESCTL_ReadByte, _2A03_preIndexed()); 
+				_2A03_SBC(NESCTL_ReadIndirectData, _2A03_preIndexed()); 
 				break;
 
 			case 0xf1: 
-				_2A03_SBC(NESCTL_ReadByte, _2A03_postIndexedCheckBounds()); 
+				_2A03_SBC(NESCTL_ReadIndirectData, _2A03_postIndexedCheckBounds()); 
 				break;
 
  			//SEC - Set carry flag//
@@ -1610,7 +2124,7 @@ void _2A03_run(void)
 				break;
 
 			case 0x8e: 
-				_2A03_STORE(X, NESCTL_write_byte, _2A03_absolute()); 
+				_2A03_STORE(X, NESCTL_write_byte, _2A03_absolute<LABELS>()); 
 				break;
 
 			//STY - Store index Y in memory//
@@ -1623,7 +2137,7 @@ void _2A03_run(void)
 				break;
 
 			case 0x8c: 
-				_2A03_STORE(Y, NESCTL_write_byte, _2A03_absolute()); 
+				_2A03_STORE(Y, NESCTL_write_byte, _2A03_absolute<LABELS>()); 
 				break;
 
 			//TAX - Transfer accumulator to index X//
@@ -1668,9 +2182,9 @@ void _2A03_run(void)
 
 			//BRK - Force break (produce a NMI) //
 			case 0x00: 
-				if(_2A03_labelHolder)
+				if(LABELS)
 				{
-					if(PC.W > 0x7fff)
+					if(PC.W > 0x7fff && nes->BankJMPList->is_new_site(PC.W, SITE_END, PC.W + 1))
 					{
 						nes->BankJMPList->insert_label(PC.W + 1, TYPE_DATA, TYPE_BYTE, 0, 0);
 					}
@@ -1697,9 +2211,30 @@ void _2A03_run(void)
 	
 	return;
 }
+
+// Picks the core matching the current tracing features
+static void _2A03_select_run(void)
+{
+	if(_2A03_labelHolder)
+	{
+		_2A03_cpu->run = _2A03_instructionLog ? _2A03_run_mode<TRUE, TRUE> : _2A03_run_mode<TRUE, FALSE>;
+	}
+	else
+	{
+		_2A03_cpu->run = _2A03_instructionLog ? _2A03_run_mode<FALSE, TRUE> : _2A03_run_mode<FALSE, FALSE>;
+	}
+}
+
+void _2A03_run(void)
+{
+	_2A03_events = TRUE;
+	_2A03_cpu->run();
+}
+
 void _2A03_toggle_label_holder(void)
 {
     _2A03_labelHolder = (_2A03_labelHolder) ? FALSE : TRUE;
+    _2A03_select_run();
 }
 void _2A03_toggle_tracer(void)
 {
@@ -1708,10 +2243,12 @@ void _2A03_toggle_tracer(void)
 void _2A03_toggle_logtracer(void)
 {
     _2A03_instructionLog = (_2A03_instructionLog) ? FALSE : TRUE;
+    _2A03_select_run();
 }
 void _2A03_set_label_holder(__BOOL status)
 {
     _2A03_labelHolder = status;
+    _2A03_select_run();
 }
 void _2A03_set_tracer(__BOOL status)
 {
@@ -1724,6 +2261,7 @@ __BOOL _2A03_get_tracer(void)
 void _2A03_set_logtracer(__BOOL status)
 {
     _2A03_instructionLog = status;
+    _2A03_select_run();
 }
 __BOOL _2A03_get_logtracer(void)
 {
@@ -1808,20 +2346,91 @@ void _2A03_load_state(c_tracer &TDump)
 	TDump.read(&_2A03_NMISecondRequested, 1);
 }
 
-void _2A03_disassembleInstruction(__INT_32 iROMOffset)
+// Only stores what the text has to show, see _2A03_render_trace_record ()
+void _2A03_trace_instruction(__UINT_16 address)
+{
+	register s_trace_record *record = nes->instruction_trace.add_record();
+	register __UINT_8 instruction = NESPRGRAM_ReadByte(address);
+	__UINT_16 operand;
+
+	record->cycle = _2A03_getRelativeTime();
+	record->pc = address;
+	record->bank = nes->o_mapper->get_real_prg_bank_number(address);
+	record->a = (__UINT_8) A;
+	record->x = X;
+	record->y = Y;
+	record->s = S;
+	record->sp = SP;
+	record->opcode[0] = instruction;
+	record->opcode[1] = NESPRGRAM_ReadByte(address + 1);
+	record->opcode[2] = NESPRGRAM_ReadByte(address + 2);
+	record->pointer = 0;
+	record->value = 0;
+	record->kind = TRACE_INSTRUCTION;
+
+	operand = record->opcode[1] | (record->opcode[2] << 8);
+	switch(_2A03_instructionAddrMode[instruction])
+	{
+		case ZPA:
+			record->value = NESPRGRAM_ReadByte(record->opcode[1]);
+			break;
+
+		case ZPX:
+			record->value = NESPRGRAM_ReadByte((record->opcode[1] + X) & 0xff);
+			break;
+
+		case ZPY:
+			record->value = NESPRGRAM_ReadByte((record->opcode[1] + Y) & 0xff);
+			break;
+
+		case AB_:
+			record->value = NESPRGRAM_ReadByte(operand);
+			break;
+
+		case ABX:
+			record->value = NESPRGRAM_ReadByte((__UINT_16) (operand + X));
+			break;
+
+		case ABY:
+			record->value = NESPRGRAM_ReadByte((__UINT_16) (operand + Y));
+			break;
+
+		case IDR:
+			record->pointer = NESPRGRAM_ReadByte(operand);
+			record->pointer += NESPRGRAM_ReadByte(operand + 1) << 8;
+			break;
+
+		case PRE:
+			record->pointer = NESPRGRAM_ReadByte((record->opcode[1] + X) & 0xff);
+			record->pointer += NESPRGRAM_ReadByte((record->opcode[1] + 1 + X) & 0xff) << 8;
+			record->value = NESPRGRAM_ReadByte(record->pointer);
+			break;
+
+		case POS:
+			record->pointer = NESPRGRAM_ReadByte(record->opcode[1]);
+			record->pointer += NESPRGRAM_ReadByte((record->opcode[1] + 1) & 0xff) << 8;
+			record->pointer += Y;
+			record->value = NESPRGRAM_ReadByte(record->pointer);
+			break;
+	}
+}
+
+void _2A03_render_trace_record(c_tracer &out, s_trace_record *record)
 {
-	nes->general_log.f_write("bsws", nes->o_mapper->get_real_prg_bank_number(iROMOffset), ":", iROMOffset, " ");
-	nes->general_log.f_write("sbsbsbsb", "A=", A, " X=", X, " Y=", Y, " SP=", SP);
-	nes->general_log.f_write("s", " F= ");
-	nes->general_log.f_write("s", (S & BIT_7) ? "N " : "  ");
-	nes->general_log.f_write("s", (S & BIT_6) ? "V " : "  ");
-	nes->general_log.f_write("s", (S & BIT_4) ? "B " : "  ");
-	nes->general_log.f_write("s", (S & BIT_3) ? "D " : "  ");
-	nes->general_log.f_write("s", (S & BIT_2) ? "I " : "  ");
-	nes->general_log.f_write("s", (S & BIT_1) ? "Z " : "  ");
-	nes->general_log.f_write("s", (S & BIT_0) ? "C " : "  ");
-	nes->general_log.f_write("sds", " Cycle:", _2A03_getRelativeTime(), " ");
-	nes->general_log.f_write("ss", _2A03_instructionSet[NESPRGRAM_ReadByte(iROMOffset)], " ");
+	__UINT_8 flags = record->s;
+
+	out.f_write("bsws", record->bank, ":", record->pc, " ");
+	out.f_write("sbsbsbsb", "A=", record->a, " X=", record->x, " Y=", record->y, " SP=", record->sp);
+	out.f_write("s", " F= ");
+	out.f_write("s", (flags & BIT_7) ? "N " : "  ");
+	out.f_write("s", (flags & BIT_6) ? "V " : "  ");
+	out.f_write("s", (flags & BIT_4) ? "B " : "  ");
+	out.f_write("s", (flags & BIT_3) ? "D " : "  ");
+	out.f_write("s", (flags & BIT_2) ? "I " : "  ");
+	out.f_write("s", (flags & BIT_1) ? "Z " : "  ");
+	out.f_write("s", (flags & BIT_0) ? "C " : "  ");
+	out.f_write("sds", " Cycle:", record->cycle, " ");
+	out.f_write("ss", _2A03_instructionSet[record->opcode[0]], " ");
 
 	union NESROMData
 	{
@@ -1831,91 +2440,68 @@ void _2A03_disassembleInstruction(__INT_32 iROMOffset)
 
 	NESROMData addr;
 
-	switch(_2A03_instructionAddrMode[NESPRGRAM_ReadByte(iROMOffset)])
+	read.w = record->opcode[1] | (record->opcode[2] << 8);
+	switch(_2A03_instructionAddrMode[record->opcode[0]])
 	{
 		case IMM:
-			read.b = NESPRGRAM_ReadByte(++iROMOffset);
-			nes->general_log.f_write("sb", "#", read.b);
+			out.f_write("sb", "#", read.b);
 			break;
 
 		case ZPA:
-			read.b = NESPRGRAM_ReadByte(++iROMOffset);
-			nes->general_log.f_write("bsbs", read.b, " (", NESPRGRAM_ReadByte(read.b), ")");
+			out.f_write("bsbs", read.b, " (", record->value, ")");
 			break;
 
 		case ZPX:
-			read.b = NESPRGRAM_ReadByte(++iROMOffset);
-			nes->general_log.f_write("bsbs", read.b, ", x (", NESPRGRAM_ReadByte((read.b + X) & 0xff), ")");
+			out.f_write("bsbs", read.b, ", x (", record->value, ")");
 			break;
 
 		case ZPY:
-			read.b = NESPRGRAM_ReadByte(++iROMOffset);
-			nes->general_log.f_write("bsbs", read.b, ", y (", NESPRGRAM_ReadByte((read.b + Y) & 0xff), ")");
+			out.f_write("bsbs", read.b, ", y (", record->value, ")");
 			break;
 
 		case JMP:
-			read.w = NESPRGRAM_ReadByte(++iROMOffset);
-			read.w += NESPRGRAM_ReadByte(++iROMOffset) << 8;
-			nes->general_log.f_write("w", read.w);
+			out.f_write("w", read.w);
 			break;
 
 		case AB_:
-			read.w = NESPRGRAM_ReadByte(++iROMOffset);
-			read.w += NESPRGRAM_ReadByte(++iROMOffset) << 8;
-			nes->general_log.f_write("wsbs", read.w, " (", NESPRGRAM_ReadByte(read.w), ")");
+			out.f_write("wsbs", read.w, " (", record->value, ")");
 			break;
 
 		case ABX:
-			read.w = NESPRGRAM_ReadByte(++iROMOffset);
-			read.w += NESPRGRAM_ReadByte(++iROMOffset) << 8;
-			addr.w = read.w + X;
-			nes->general_log.f_write("wswsbs", read.w, ", x (", addr.w, ") (", NESPRGRAM_ReadByte(addr.w), "))");
+			addr.w = read.w + record->x;
+			out.f_write("wswsbs", read.w, ", x (", addr.w, ") (", record->value, "))");
 			break;
 
 		case ABY:
-			read.w = NESPRGRAM_ReadByte(++iROMOffset);
-			read.w += NESPRGRAM_ReadByte(++iROMOffset) << 8;
-			addr.w = read.w + Y;
-			nes->general_log.f_write("wswsbs", read.w, ", y (", addr.w, ") (", NESPRGRAM_ReadByte(addr.w), "))");
+			addr.w = read.w + record->y;
+			out.f_write("wswsbs", read.w, ", y (", addr.w, ") (", record->value, "))");
 			break;
 
 		case IDR:
-			read.w = NESPRGRAM_ReadByte(++iROMOffset);
-			read.w += NESPRGRAM_ReadByte(++iROMOffset) << 8;
-			addr.w = NESPRGRAM_ReadByte(read.w);
-			addr.w += NESPRGRAM_ReadByte(read.w + 1) << 8;
-			nes->general_log.f_write("swsws", "(", read.w, ") (", addr.w, ")");
+			out.f_write("swsws", "(", read.w, ") (", record->pointer, ")");
 			break;
 
 		case PRE:
-			read.b = NESPRGRAM_ReadByte(++iROMOffset);
-			addr.w = NESPRGRAM_ReadByte((read.b + X) & 0xff);
-			addr.w += NESPRGRAM_ReadByte((read.b + 1 + X) & 0xff) << 8;
-			nes->general_log.f_write("sbswsbs", "(", read.b, ", x) (", addr.w, " (", NESPRGRAM_ReadByte(addr.w), "))");
+			out.f_write("sbswsbs", "(", read.b, ", x) (", record->pointer, " (", record->value, "))");
 			break;
 
 		case POS:
-			read.b = NESPRGRAM_ReadByte(++iROMOffset);
-			addr.w = NESPRGRAM_ReadByte(read.b);
-			addr.w += NESPRGRAM_ReadByte((read.b + 1) & 0xff) << 8;
-			addr.w += Y;
-			nes->general_log.f_write("sbswsbs", "(", read.b, "), y (", addr.w, " (", NESPRGRAM_ReadByte(addr.w), "))");
+			out.f_write("sbswsbs", "(", read.b, "), y (", record->pointer, " (", record->value, "))");
 			break;
 
 		case IMP:
 			break;
 
 		case REL:
-			read.w = ++iROMOffset;
-			read.w += (INT_8)(NESPRGRAM_ReadByte(iROMOffset)) + 1;
-			nes->general_log.f_write("w", read.w);
+			addr.w = record->pc + 2 + (INT_8) read.b;
+			out.f_write("w", addr.w);
 			break;
 
         case NIL:
 			break;
 	}
 
-	nes->general_log.f_write("s", "\r\n");
+	out.f_write("s", "\r\n");
 }
 
 int _2A03_Check_Code_Sanity(char *operands,
@@ -1999,7 +2585,7 @@ stop_search:
     }
 }
 
-int _2A03_get_instruction(int base_addr,
+int _2A03_get_instruction(int base_address,
                           int address,
                           int bank_lo,
                           int bank_hi,
@@ -2722,7 +3308,7 @@ int _2A03_get_instruction(int base_addr,
     return(length);
 }
 
-int _2A03_map_instruction(int base_addr,
+int _2A03_map_instruction(int base_address,
                           int address,
                           int bank,
                           __INT_32 iROMOffset,
@@ -0,0 +1,1226 @@
+/*******************************************************************************
+    crudNES - A NES emulator for reverse engineering purposes
+	2A03 Blocks Translator
+    Copyright (C) 2023-2024 Franck "hitchhikr" Charlet
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*******************************************************************************/
+
+#include <windows.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "include/2a03.h"
+#include "include/2a03_dynarec.h"
+#include "include/datatypes.h"
+
+#ifdef _2A03_DYNAREC
+
+/******************************************************************************/
+/** Blocks Translator                                                        **/
+/**                                                                          **/
+/** Straight PRG-ROM code is translated to x86-32 code which runs up to the  **/
+/** next access to something else than plain memory (PPU, APU and mappers    **/
+/** registers), the end of the time slice or an instruction changing the     **/
+/** interrupts state (CLI, PLP, RTI, BRK), the interpreter runs these.       **/
+/**                                                                          **/
+/** Host registers: ebx = A, esi = X, edi = Y, cl = status flags,            **/
+/** ebp = current time, eax and edx are scratch.                             **/
+/******************************************************************************/
+
+#define IMM 0
+#define ZPA 1
+#define ZPX 2
+#define ZPY 3
+#define AB_ 4
+#define ABX 5
+#define ABY 6
+#define PRE 8
+#define POS 9
+#define IMP 10
+#define REL 11
+#define JMP 12
+
+static __UINT_8 _2A03_blockModeLength[] =
+{
+	2, 2, 2, 2, 3, 3, 3, 3, 2, 2, 1, 2, 3
+};
+
+#define C BIT_0
+#define Z BIT_1
+#define I BIT_2
+#define D BIT_3
+#define FLAG_B BIT_4
+#define V BIT_6
+#define N BIT_7
+
+#define _2A03_FIX_CYCLES(Count) ((Count) * 3 * 16)
+
+// Executable memory of a context (flushed once full)
+#define _2A03_CODE_SIZE (4 * 1024 * 1024)
+// Room needed by the longest block and its exits
+#define _2A03_BLOCK_ROOM (16 * 1024)
+#define _2A03_BLOCK_INSTRUCTIONS 64
+#define _2A03_BLOCK_EXITS (_2A03_BLOCK_INSTRUCTIONS * 4)
+
+#define _2A03_ALIGN(size) (((size) + 15) & ~15)
+
+// Host registers
+#define _2A03_EAX 0
+#define _2A03_EDX 2
+#define _2A03_EBX 3
+#define _2A03_ESI 6
+#define _2A03_EDI 7
+
+// Second byte of the x86 conditional jumps (0 for a jmp)
+#define _2A03_JMP 0x00
+#define _2A03_JZ 0x84
+#define _2A03_JNZ 0x85
+#define _2A03_JGE 0x8d
+#define _2A03_JG 0x8f
+
+// Instructions
+enum e_2A03_operation
+{
+	OP_LDA, OP_LDX, OP_LDY, OP_STA, OP_STX, OP_STY,
+	OP_ADC, OP_SBC, OP_AND, OP_ORA, OP_EOR, OP_BIT,
+	OP_CMP, OP_CPX, OP_CPY,
+	OP_ASL, OP_LSR, OP_ROL, OP_ROR, OP_INC, OP_DEC,
+	OP_ASLA, OP_LSRA, OP_ROLA, OP_RORA,
+	OP_INX, OP_INY, OP_DEX, OP_DEY,
+	OP_TAX, OP_TAY, OP_TXA, OP_TYA, OP_TSX, OP_TXS,
+	OP_PHA, OP_PHP, OP_PLA,
+	OP_CLC, OP_SEC, OP_CLD, OP_CLV, OP_SEI, OP_NOP,
+	OP_BRANCH, OP_JMP, OP_JSR, OP_RTS
+};
+
+// Memory accesses
+enum e_2A03_access
+{
+	ACCESS_NONE, ACCESS_READ, ACCESS_WRITE, ACCESS_MODIFY
+};
+
+struct s_2A03_dynarec
+{
+	// The exit code comes first, then the blocks
+	__UINT_8 *code;
+	__INT_32 used;
+	__INT_32 exit_size;
+	__UINT_8 **read_pages;
+	__UINT_8 **write_pages;
+	__UINT_8 *ram;
+};
+
+// Jump to the exit code
+struct s_2A03_exit
+{
+	__UINT_8 *fixup;
+	__UINT_8 *stub;
+	// Address to resume at (-1 if the block stored it)
+	int pc;
+	int instructions;
+	__INT_32 cycles;
+};
+
+struct s_2A03_translation
+{
+	s_2A03_context *context;
+	s_2A03_dynarec *dynarec;
+	__UINT_8 *out;
+	// Instruction being translated
+	__UINT_16 pc;
+	int index;
+	s_2A03_exit exits[_2A03_BLOCK_EXITS];
+	int nbr_exits;
+};
+
+// N and Z flags of a value
+static __UINT_8 _2A03_nz_flags[0x100];
+
+/******************************************************************************/
+/** Code Emission                                                            **/
+/******************************************************************************/
+
+static void _2A03_emit(s_2A03_translation *t, int count, ...)
+{
+	va_list bytes;
+
+	va_start(bytes, count);
+	while(count--)
+	{
+		*t->out++ = (__UINT_8) va_arg(bytes, int);
+	}
+	va_end(bytes);
+}
+
+static void _2A03_emit_16(s_2A03_translation *t, __UINT_16 value)
+{
+	*(__UINT_16 *) t->out = value;
+	t->out += 2;
+}
+
+static void _2A03_emit_32(s_2A03_translation *t, __UINT_32 value)
+{
+	*(__UINT_32 *) t->out = value;
+	t->out += 4;
+}
+
+static void _2A03_emit_address(s_2A03_translation *t, void *address)
+{
+	_2A03_emit_32(t, (__UINT_32) address);
+}
+
+// The stub storing the resuming address is emitted after the block
+static void _2A03_jump_exit(s_2A03_translation *t, __UINT_8 condition, int pc, int instructions, __INT_32 cycles)
+{
+	register s_2A03_exit *exit = &t->exits[t->nbr_exits++];
+
+	if(condition)
+	{
+		_2A03_emit(t, 2, 0x0f, condition);
+	}
+	else
+	{
+		_2A03_emit(t, 1, 0xe9);
+	}
+	exit->fixup = t->out;
+	exit->pc = pc;
+	exit->instructions = instructions;
+	exit->cycles = cycles;
+	_2A03_emit_32(t, 0);
+}
+
+// Leaves before the current instruction (the interpreter will run it)
+static void _2A03_exit_before(s_2A03_translation *t, __UINT_8 condition)
+{
+	_2A03_jump_exit(t, condition, t->pc, t->index, 0);
+}
+
+static void _2A03_emit_exits(s_2A03_translation *t)
+{
+	register s_2A03_exit *exit;
+	register int i;
+	register int j;
+
+	for(i = 0; i < t->nbr_exits; i++)
+	{
+		exit = &t->exits[i];
+		exit->stub = NULL;
+		for(j = 0; j < i; j++)
+		{
+			if(t->exits[j].pc == exit->pc &&
+			   t->exits[j].instructions == exit->instructions &&
+			   t->exits[j].cycles == exit->cycles)
+			{
+				exit->stub = t->exits[j].stub;
+				break;
+			}
+		}
+		if(!exit->stub)
+		{
+			exit->stub = t->out;
+			if(exit->cycles)
+			{
+				// add ebp, cycles
+				_2A03_emit(t, 2, 0x81, 0xc5);
+				_2A03_emit_32(t, exit->cycles);
+			}
+			if(exit->pc >= 0)
+			{
+				// mov word [PC], pc
+				_2A03_emit(t, 3, 0x66, 0xc7, 0x05);
+				_2A03_emit_address(t, &t->context->PC.W);
+				_2A03_emit_16(t, (__UINT_16) exit->pc);
+			}
+			// mov eax, instructions / jmp exit code
+			_2A03_emit(t, 1, 0xb8);
+			_2A03_emit_32(t, exit->instructions);
+			_2A03_emit(t, 1, 0xe9);
+			_2A03_emit_32(t, t->dynarec->code - (t->out + 4));
+		}
+		*(__INT_32 *) exit->fixup = exit->stub - (exit->fixup + 4);
+	}
+}
+
+// Loads the registers from the context
+static void _2A03_emit_entry(s_2A03_translation *t)
+{
+	// push ebp / push ebx / push esi / push edi
+	_2A03_emit(t, 4, 0x55, 0x53, 0x56, 0x57);
+	// movzx ebx, word [A]
+	_2A03_emit(t, 3, 0x0f, 0xb7, 0x1d);
+	_2A03_emit_address(t, &t->context->A);
+	// movzx esi, byte [X]
+	_2A03_emit(t, 3, 0x0f, 0xb6, 0x35);
+	_2A03_emit_address(t, &t->context->X);
+	// movzx edi, byte [Y]
+	_2A03_emit(t, 3, 0x0f, 0xb6, 0x3d);
+	_2A03_emit_address(t, &t->context->Y);
+	// movzx ecx, byte [S]
+	_2A03_emit(t, 3, 0x0f, 0xb6, 0x0d);
+	_2A03_emit_address(t, &t->context->S);
+	// mov ebp, [iCurrentTime]
+	_2A03_emit(t, 2, 0x8b, 0x2d);
+	_2A03_emit_address(t, &t->context->iCurrentTime);
+}
+
+// Stores the registers back, eax holds the number of instructions run
+static void _2A03_emit_exit_code(s_2A03_translation *t)
+{
+	// mov [A], bx
+	_2A03_emit(t, 3, 0x66, 0x89, 0x1d);
+	_2A03_emit_address(t, &t->context->A);
+	// mov edx, esi / mov [X], dl
+	_2A03_emit(t, 4, 0x89, 0xf2, 0x88, 0x15);
+	_2A03_emit_address(t, &t->context->X);
+	// mov edx, edi / mov [Y], dl
+	_2A03_emit(t, 4, 0x89, 0xfa, 0x88, 0x15);
+	_2A03_emit_address(t, &t->context->Y);
+	// mov [S], cl
+	_2A03_emit(t, 2, 0x88, 0x0d);
+	_2A03_emit_address(t, &t->context->S);
+	// mov [iCurrentTime], ebp
+	_2A03_emit(t, 2, 0x89, 0x2d);
+	_2A03_emit_address(t, &t->context->iCurrentTime);
+	// pop edi / pop esi / pop ebx / pop ebp / ret
+	_2A03_emit(t, 5, 0x5f, 0x5e, 0x5b, 0x5d, 0xc3);
+}
+
+// Sets N and Z from a host register
+static void _2A03_emit_nz(s_2A03_translation *t, int reg)
+{
+	// and cl, ~(N | Z) / or cl, [nz_flags + reg]
+	_2A03_emit(t, 5, 0x80, 0xe1, (__UINT_8) ~(N | Z), 0x0a, 0x88 | reg);
+	_2A03_emit_address(t, _2A03_nz_flags);
+}
+
+// Stops where the interpreter would: at the end of the time slice,
+// or before an access which doesn't fit in it
+static void _2A03_emit_time_check(s_2A03_translation *t, __INT_32 cycles, __BOOL access)
+{
+	if(access)
+	{
+		// lea edx, [ebp + cycles] / cmp edx, [iEndTime] / jg exit
+		_2A03_emit(t, 2, 0x8d, 0x95);
+		_2A03_emit_32(t, cycles);
+		_2A03_emit(t, 2, 0x3b, 0x15);
+		_2A03_emit_address(t, &t->context->iEndTime);
+		_2A03_exit_before(t, _2A03_JG);
+	}
+	// (the block is entered before the end of the time slice)
+	else if(t->index)
+	{
+		// cmp ebp, [iEndTime] / jge exit
+		_2A03_emit(t, 2, 0x3b, 0x2d);
+		_2A03_emit_address(t, &t->context->iEndTime);
+		_2A03_exit_before(t, _2A03_JGE);
+	}
+}
+
+// Leaves the host address of the operand in edx, the registers
+// (unmapped pages) are left to the interpreter
+static void _2A03_emit_operand(s_2A03_translation *t, int mode, __UINT_16 operand, __UINT_8 **pages)
+{
+	register __UINT_8 *ram = t->dynarec->ram;
+
+	switch(mode)
+	{
+		case ZPA:
+			// mov edx, ram + operand
+			_2A03_emit(t, 1, 0xba);
+			_2A03_emit_address(t, ram + operand);
+			return;
+
+		case ZPX:
+		case ZPY:
+			// lea edx, [esi / edi + operand] / movzx edx, dl / add edx, ram
+			_2A03_emit(t, 2, 0x8d, mode == ZPX ? 0x96 : 0x97);
+			_2A03_emit_32(t, operand);
+			_2A03_emit(t, 5, 0x0f, 0xb6, 0xd2, 0x81, 0xc2);
+			_2A03_emit_address(t, ram);
+			return;
+
+		case AB_:
+			// The RAM is mirrored up to 0x1fff
+			if(operand < 0x2000)
+			{
+				// mov edx, ram + operand
+				_2A03_emit(t, 1, 0xba);
+				_2A03_emit_address(t, ram + (operand & 0x7ff));
+				return;
+			}
+			// mov edx, [pages + page] / test edx, edx / jz exit
+			_2A03_emit(t, 2, 0x8b, 0x15);
+			_2A03_emit_address(t, &pages[operand >> 8]);
+			_2A03_emit(t, 2, 0x85, 0xd2);
+			_2A03_exit_before(t, _2A03_JZ);
+			if(operand & 0xff)
+			{
+				// add edx, offset
+				_2A03_emit(t, 2, 0x81, 0xc2);
+				_2A03_emit_32(t, operand & 0xff);
+			}
+			return;
+
+		case ABX:
+		case ABY:
+			// lea eax, [esi / edi + operand] / movzx eax, ax
+			_2A03_emit(t, 2, 0x8d, mode == ABX ? 0x86 : 0x87);
+			_2A03_emit_32(t, operand);
+			_2A03_emit(t, 3, 0x0f, 0xb7, 0xc0);
+			break;
+
+		case PRE:
+			// lea edx, [esi + operand] / movzx edx, dl
+			_2A03_emit(t, 2, 0x8d, 0x96);
+			_2A03_emit_32(t, operand);
+			_2A03_emit(t, 3, 0x0f, 0xb6, 0xd2);
+			// movzx eax, byte [edx + ram] / inc dl
+			_2A03_emit(t, 3, 0x0f, 0xb6, 0x82);
+			_2A03_emit_address(t, ram);
+			_2A03_emit(t, 2, 0xfe, 0xc2);
+			// movzx edx, byte [edx + ram] / shl edx, 8 / or eax, edx
+			_2A03_emit(t, 3, 0x0f, 0xb6, 0x92);
+			_2A03_emit_address(t, ram);
+			_2A03_emit(t, 5, 0xc1, 0xe2, 0x08, 0x09, 0xd0);
+			break;
+
+		case POS:
+			// movzx eax, byte [ram + operand]
+			_2A03_emit(t, 3, 0x0f, 0xb6, 0x05);
+			_2A03_emit_address(t, ram + operand);
+			// movzx edx, byte [ram + operand + 1]
+			_2A03_emit(t, 3, 0x0f, 0xb6, 0x15);
+			_2A03_emit_address(t, ram + ((operand + 1) & 0xff));
+			// shl edx, 8 / or eax, edx / add eax, edi / movzx eax, ax
+			_2A03_emit(t, 10, 0xc1, 0xe2, 0x08, 0x09, 0xd0, 0x01, 0xf8, 0x0f, 0xb7, 0xc0);
+			break;
+	}
+	// movzx edx, ah / mov edx, [pages + edx * 4] / test edx, edx / jz exit
+	_2A03_emit(t, 6, 0x0f, 0xb6, 0xd4, 0x8b, 0x14, 0x95);
+	_2A03_emit_address(t, pages);
+	_2A03_emit(t, 2, 0x85, 0xd2);
+	_2A03_exit_before(t, _2A03_JZ);
+	// movzx eax, al / add edx, eax
+	_2A03_emit(t, 5, 0x0f, 0xb6, 0xc0, 0x01, 0xc2);
+}
+
+// The indexed reads take one more cycle when crossing a page
+static void _2A03_emit_page_cross(s_2A03_translation *t, int mode, __UINT_16 operand)
+{
+	switch(mode)
+	{
+		case ABX:
+		case ABY:
+			// cmp esi / edi, 0xff - low byte
+			_2A03_emit(t, 2, 0x81, mode == ABX ? 0xfe : 0xff);
+			_2A03_emit_32(t, 0xff - (operand & 0xff));
+			break;
+
+		case POS:
+			// movzx eax, byte [ram + operand] / add eax, edi / cmp eax, 0xff
+			_2A03_emit(t, 3, 0x0f, 0xb6, 0x05);
+			_2A03_emit_address(t, t->dynarec->ram + operand);
+			_2A03_emit(t, 3, 0x01, 0xf8, 0x3d);
+			_2A03_emit_32(t, 0xff);
+			break;
+
+		default:
+			return;
+	}
+	// jbe $ + 3 / add ebp, 1 cycle
+	_2A03_emit(t, 5, 0x76, 0x03, 0x83, 0xc5, _2A03_FIX_CYCLES(1));
+}
+
+// movzx edx, byte [SP]
+static void _2A03_emit_load_sp(s_2A03_translation *t)
+{
+	_2A03_emit(t, 3, 0x0f, 0xb6, 0x15);
+	_2A03_emit_address(t, &t->context->SP);
+}
+
+// mov [SP], dl
+static void _2A03_emit_store_sp(s_2A03_translation *t)
+{
+	_2A03_emit(t, 2, 0x88, 0x15);
+	_2A03_emit_address(t, &t->context->SP);
+}
+
+// mov byte [edx + stack], value / dec dl
+static void _2A03_emit_push_value(s_2A03_translation *t, __UINT_8 value)
+{
+	_2A03_emit(t, 2, 0xc6, 0x82);
+	_2A03_emit_address(t, t->dynarec->ram + 0x100);
+	_2A03_emit(t, 3, value, 0xfe, 0xca);
+}
+
+// 6502 register compared to eax
+static void _2A03_emit_compare(s_2A03_translation *t, int reg)
+{
+	// mov edx, reg / sub dl, al / setnc al / movzx edx, dl
+	_2A03_emit(t, 10, 0x89, 0xc2 | (reg << 3), 0x28, 0xc2, 0x0f, 0x93, 0xc0, 0x0f, 0xb6, 0xd2);
+	// and cl, ~(N | Z | C) / or cl, al / or cl, [nz_flags + edx]
+	_2A03_emit(t, 7, 0x80, 0xe1, (__UINT_8) ~(N | Z | C), 0x08, 0xc1, 0x0a, 0x8a);
+	_2A03_emit_address(t, _2A03_nz_flags);
+}
+
+// Carry (in al) and overflow flags of an addition or a subtraction
+static void _2A03_emit_carry_overflow(s_2A03_translation *t)
+{
+	// seto dl / and cl, ~(N | V | Z | C) / or cl, al / shl dl, 6 / or cl, dl
+	_2A03_emit(t, 13, 0x0f, 0x90, 0xc2, 0x80, 0xe1, (__UINT_8) ~(N | V | Z | C), 0x08, 0xc1, 0xc0, 0xe2, 0x06, 0x08, 0xd1);
+	_2A03_emit_nz(t, _2A03_EBX);
+}
+
+// Flags of a shift or a rotation of [edx]
+static void _2A03_emit_shift_flags(s_2A03_translation *t)
+{
+	// movzx eax, byte [edx] / or cl, [nz_flags + eax]
+	_2A03_emit(t, 5, 0x0f, 0xb6, 0x02, 0x0a, 0x88);
+	_2A03_emit_address(t, _2A03_nz_flags);
+}
+
+/******************************************************************************/
+/** Instructions                                                             **/
+/******************************************************************************/
+
+// Returns the length of the translated instruction, 0 if the block
+// has to end before it
+static int _2A03_translate_instruction(s_2A03_translation *t, const __UINT_8 *code, int length, __BOOL *last)
+{
+	register s_2A03_dynarec *dynarec = t->dynarec;
+	register __UINT_8 opcode = code[0];
+	__UINT_16 operand;
+	__INT_32 cycles;
+	int operation;
+	int mode;
+	int access;
+	int size;
+	int target;
+
+	switch(opcode)
+	{
+		case 0xa9: operation = OP_LDA; mode = IMM; break;
+		case 0xa5: operation = OP_LDA; mode = ZPA; break;
+		case 0xb5: operation = OP_LDA; mode = ZPX; break;
+		case 0xad: operation = OP_LDA; mode = AB_; break;
+		case 0xbd: operation = OP_LDA; mode = ABX; break;
+		case 0xb9: operation = OP_LDA; mode = ABY; break;
+		case 0xa1: operation = OP_LDA; mode = PRE; break;
+		case 0xb1: operation = OP_LDA; mode = POS; break;
+
+		case 0xa2: operation = OP_LDX; mode = IMM; break;
+		case 0xa6: operation = OP_LDX; mode = ZPA; break;
+		case 0xb6: operation = OP_LDX; mode = ZPY; break;
+		case 0xae: operation = OP_LDX; mode = AB_; break;
+		case 0xbe: operation = OP_LDX; mode = ABY; break;
+
+		case 0xa0: operation = OP_LDY; mode = IMM; break;
+		case 0xa4: operation = OP_LDY; mode = ZPA; break;
+		case 0xb4: operation = OP_LDY; mode = ZPX; break;
+		case 0xac: operation = OP_LDY; mode = AB_; break;
+		case 0xbc: operation = OP_LDY; mode = ABX; break;
+
+		case 0x85: operation = OP_STA; mode = ZPA; break;
+		case 0x95: operation = OP_STA; mode = ZPX; break;
+		case 0x8d: operation = OP_STA; mode = AB_; break;
+		case 0x9d: operation = OP_STA; mode = ABX; break;
+		case 0x99: operation = OP_STA; mode = ABY; break;
+		case 0x81: operation = OP_STA; mode = PRE; break;
+		case 0x91: operation = OP_STA; mode = POS; break;
+
+		case 0x86: operation = OP_STX; mode = ZPA; break;
+		case 0x96: operation = OP_STX; mode = ZPY; break;
+		case 0x8e: operation = OP_STX; mode = AB_; break;
+
+		case 0x84: operation = OP_STY; mode = ZPA; break;
+		case 0x94: operation = OP_STY; mode = ZPX; break;
+		case 0x8c: operation = OP_STY; mode = AB_; break;
+
+		case 0x69: operation = OP_ADC; mode = IMM; break;
+		case 0x65: operation = OP_ADC; mode = ZPA; break;
+		case 0x75: operation = OP_ADC; mode = ZPX; break;
+		case 0x6d: operation = OP_ADC; mode = AB_; break;
+		case 0x7d: operation = OP_ADC; mode = ABX; break;
+		case 0x79: operation = OP_ADC; mode = ABY; break;
+		case 0x61: operation = OP_ADC; mode = PRE; break;
+		case 0x71: operation = OP_ADC; mode = POS; break;
+
+		case 0xe9: operation = OP_SBC; mode = IMM; break;
+		case 0xe5: operation = OP_SBC; mode = ZPA; break;
+		case 0xf5: operation = OP_SBC; mode = ZPX; break;
+		case 0xed: operation = OP_SBC; mode = AB_; break;
+		case 0xfd: operation = OP_SBC; mode = ABX; break;
+		case 0xf9: operation = OP_SBC; mode = ABY; break;
+		case 0xe1: operation = OP_SBC; mode = PRE; break;
+		case 0xf1: operation = OP_SBC; mode = POS; break;
+
+		case 0x29: operation = OP_AND; mode = IMM; break;
+		case 0x25: operation = OP_AND; mode = ZPA; break;
+		case 0x35: operation = OP_AND; mode = ZPX; break;
+		case 0x2d: operation = OP_AND; mode = AB_; break;
+		case 0x3d: operation = OP_AND; mode = ABX; break;
+		case 0x39: operation = OP_AND; mode = ABY; break;
+		case 0x21: operation = OP_AND; mode = PRE; break;
+		case 0x31: operation = OP_AND; mode = POS; break;
+
+		case 0x09: operation = OP_ORA; mode = IMM; break;
+		case 0x05: operation = OP_ORA; mode = ZPA; break;
+		case 0x15: operation = OP_ORA; mode = ZPX; break;
+		case 0x0d: operation = OP_ORA; mode = AB_; break;
+		case 0x1d: operation = OP_ORA; mode = ABX; break;
+		case 0x19: operation = OP_ORA; mode = ABY; break;
+		case 0x01: operation = OP_ORA; mode = PRE; break;
+		case 0x11: operation = OP_ORA; mode = POS; break;
+
+		case 0x49: operation = OP_EOR; mode = IMM; break;
+		case 0x45: operation = OP_EOR; mode = ZPA; break;
+		case 0x55: operation = OP_EOR; mode = ZPX; break;
+		case 0x4d: operation = OP_EOR; mode = AB_; break;
+		case 0x5d: operation = OP_EOR; mode = ABX; break;
+		case 0x59: operation = OP_EOR; mode = ABY; break;
+		case 0x41: operation = OP_EOR; mode = PRE; break;
+		case 0x51: operation = OP_EOR; mode = POS; break;
+
+		case 0xc9: operation = OP_CMP; mode = IMM; break;
+		case 0xc5: operation = OP_CMP; mode = ZPA; break;
+		case 0xd5: operation = OP_CMP; mode = ZPX; break;
+		case 0xcd: operation = OP_CMP; mode = AB_; break;
+		case 0xdd: operation = OP_CMP; mode = ABX; break;
+		case 0xd9: operation = OP_CMP; mode = ABY; break;
+		case 0xc1: operation = OP_CMP; mode = PRE; break;
+		case 0xd1: operation = OP_CMP; mode = POS; break;
+
+		case 0xe0: operation = OP_CPX; mode = IMM; break;
+		case 0xe4: operation = OP_CPX; mode = ZPA; break;
+		case 0xec: operation = OP_CPX; mode = AB_; break;
+
+		case 0xc0: operation = OP_CPY; mode = IMM; break;
+		case 0xc4: operation = OP_CPY; mode = ZPA; break;
+		case 0xcc: operation = OP_CPY; mode = AB_; break;
+
+		case 0x24: operation = OP_BIT; mode = ZPA; break;
+		case 0x2c: operation = OP_BIT; mode = AB_; break;
+
+		case 0x06: operation = OP_ASL; mode = ZPA; break;
+		case 0x16: operation = OP_ASL; mode = ZPX; break;
+		case 0x0e: operation = OP_ASL; mode = AB_; break;
+		case 0x1e: operation = OP_ASL; mode = ABX; break;
+
+		case 0x46: operation = OP_LSR; mode = ZPA; break;
+		case 0x56: operation = OP_LSR; mode = ZPX; break;
+		case 0x4e: operation = OP_LSR; mode = AB_; break;
+		case 0x5e: operation = OP_LSR; mode = ABX; break;
+
+		case 0x26: operation = OP_ROL; mode = ZPA; break;
+		case 0x36: operation = OP_ROL; mode = ZPX; break;
+		case 0x2e: operation = OP_ROL; mode = AB_; break;
+		case 0x3e: operation = OP_ROL; mode = ABX; break;
+
+		case 0x66: operation = OP_ROR; mode = ZPA; break;
+		case 0x76: operation = OP_ROR; mode = ZPX; break;
+		case 0x6e: operation = OP_ROR; mode = AB_; break;
+		case 0x7e: operation = OP_ROR; mode = ABX; break;
+
+		case 0xe6: operation = OP_INC; mode = ZPA; break;
+		case 0xf6: operation = OP_INC; mode = ZPX; break;
+		case 0xee: operation = OP_INC; mode = AB_; break;
+		case 0xfe: operation = OP_INC; mode = ABX; break;
+
+		case 0xc6: operation = OP_DEC; mode = ZPA; break;
+		case 0xd6: operation = OP_DEC; mode = ZPX; break;
+		case 0xce: operation = OP_DEC; mode = AB_; break;
+		case 0xde: operation = OP_DEC; mode = ABX; break;
+
+		case 0x0a: operation = OP_ASLA; mode = IMP; break;
+		case 0x4a: operation = OP_LSRA; mode = IMP; break;
+		case 0x2a: operation = OP_ROLA; mode = IMP; break;
+		case 0x6a: operation = OP_RORA; mode = IMP; break;
+
+		case 0xe8: operation = OP_INX; mode = IMP; break;
+		case 0xc8: operation = OP_INY; mode = IMP; break;
+		case 0xca: operation = OP_DEX; mode = IMP; break;
+		case 0x88: operation = OP_DEY; mode = IMP; break;
+
+		case 0xaa: operation = OP_TAX; mode = IMP; break;
+		case 0xa8: operation = OP_TAY; mode = IMP; break;
+		case 0x8a: operation = OP_TXA; mode = IMP; break;
+		case 0x98: operation = OP_TYA; mode = IMP; break;
+		case 0xba: operation = OP_TSX; mode = IMP; break;
+		case 0x9a: operation = OP_TXS; mode = IMP; break;
+
+		case 0x48: operation = OP_PHA; mode = IMP; break;
+		case 0x08: operation = OP_PHP; mode = IMP; break;
+		case 0x68: operation = OP_PLA; mode = IMP; break;
+
+		case 0x18: operation = OP_CLC; mode = IMP; break;
+		case 0x38: operation = OP_SEC; mode = IMP; break;
+		case 0xd8: operation = OP_CLD; mode = IMP; break;
+		case 0xb8: operation = OP_CLV; mode = IMP; break;
+		case 0x78: operation = OP_SEI; mode = IMP; break;
+		case 0xea: operation = OP_NOP; mode = IMP; break;
+
+		case 0x10:
+		case 0x30:
+		case 0x50:
+		case 0x70:
+		case 0x90:
+		case 0xb0:
+		case 0xd0:
+		case 0xf0:
+			operation = OP_BRANCH; mode = REL; break;
+
+		case 0x4c: operation = OP_JMP; mode = JMP; break;
+		case 0x20: operation = OP_JSR; mode = JMP; break;
+		case 0x60: operation = OP_RTS; mode = IMP; break;
+
+		// CLI, PLP, RTI, BRK, JMP (ind), SED and the undefined opcodes
+		default:
+			return 0;
+	}
+
+	size = _2A03_blockModeLength[mode];
+	if(size > length)
+	{
+		return 0;
+	}
+	operand = 0;
+	if(size > 1)
+	{
+		operand = code[1];
+	}
+	if(size > 2)
+	{
+		operand |= code[2] << 8;
+	}
+
+	switch(operation)
+	{
+		case OP_LDA: case OP_LDX: case OP_LDY:
+		case OP_ADC: case OP_SBC: case OP_AND: case OP_ORA: case OP_EOR:
+		case OP_CMP: case OP_CPX: case OP_CPY: case OP_BIT:
+			access = (mode == IMM) ? ACCESS_NONE : ACCESS_READ;
+			break;
+
+		case OP_STA: case OP_STX: case OP_STY:
+			access = ACCESS_WRITE;
+			break;
+
+		case OP_ASL: case OP_LSR: case OP_ROL: case OP_ROR:
+		case OP_INC: case OP_DEC:
+			access = ACCESS_MODIFY;
+			break;
+
+		default:
+			access = ACCESS_NONE;
+			break;
+	}
+
+	// The registers at fixed addresses are left to the interpreter
+	if(access != ACCESS_NONE && (mode == AB_ || mode == ABX || mode == ABY) &&
+	   operand >= 0x2000 && operand < 0x6000)
+	{
+		return 0;
+	}
+
+	cycles = t->context->cycleCounts[opcode];
+	_2A03_emit_time_check(t, cycles, t->context->accessCycles[opcode] != 0);
+
+	switch(access)
+	{
+		case ACCESS_READ:
+			_2A03_emit_operand(t, mode, operand, dynarec->read_pages);
+			break;
+
+		// A writable page is plain memory, it's read back from there
+		case ACCESS_WRITE:
+		case ACCESS_MODIFY:
+			_2A03_emit_operand(t, mode, operand, dynarec->write_pages);
+			break;
+	}
+
+	// add ebp, cycles
+	_2A03_emit(t, 2, 0x81, 0xc5);
+	_2A03_emit_32(t, cycles);
+
+	if(access == ACCESS_READ)
+	{
+		_2A03_emit_page_cross(t, mode, operand);
+		// movzx eax, byte [edx]
+		_2A03_emit(t, 3, 0x0f, 0xb6, 0x02);
+	}
+	else if(mode == IMM)
+	{
+		// mov eax, operand
+		_2A03_emit(t, 1, 0xb8);
+		_2A03_emit_32(t, operand);
+	}
+
+	switch(operation)
+	{
+		case OP_LDA:
+			// mov ebx, eax
+			_2A03_emit(t, 2, 0x89, 0xc3);
+			_2A03_emit_nz(t, _2A03_EBX);
+			break;
+
+		case OP_LDX:
+			// mov esi, eax
+			_2A03_emit(t, 2, 0x89, 0xc6);
+			_2A03_emit_nz(t, _2A03_ESI);
+			break;
+
+		case OP_LDY:
+			// mov edi, eax
+			_2A03_emit(t, 2, 0x89, 0xc7);
+			_2A03_emit_nz(t, _2A03_EDI);
+			break;
+
+		case OP_STA:
+			// mov [edx], bl
+			_2A03_emit(t, 2, 0x88, 0x1a);
+			break;
+
+		case OP_STX:
+			// mov eax, esi / mov [edx], al
+			_2A03_emit(t, 4, 0x89, 0xf0, 0x88, 0x02);
+			break;
+
+		case OP_STY:
+			// mov eax, edi / mov [edx], al
+			_2A03_emit(t, 4, 0x89, 0xf8, 0x88, 0x02);
+			break;
+
+		case OP_ADC:
+			// bt ecx, 0 / adc bl, al / setc al
+			_2A03_emit(t, 9, 0x0f, 0xba, 0xe1, 0x00, 0x10, 0xc3, 0x0f, 0x92, 0xc0);
+			_2A03_emit_carry_overflow(t);
+			break;
+
+		case OP_SBC:
+			// bt ecx, 0 / cmc / sbb bl, al / setnc al
+			_2A03_emit(t, 10, 0x0f, 0xba, 0xe1, 0x00, 0xf5, 0x18, 0xc3, 0x0f, 0x93, 0xc0);
+			_2A03_emit_carry_overflow(t);
+			break;
+
+		case OP_AND:
+			// and ebx, eax
+			_2A03_emit(t, 2, 0x21, 0xc3);
+			_2A03_emit_nz(t, _2A03_EBX);
+			break;
+
+		case OP_ORA:
+			// or ebx, eax
+			_2A03_emit(t, 2, 0x09, 0xc3);
+			_2A03_emit_nz(t, _2A03_EBX);
+			break;
+
+		case OP_EOR:
+			// xor ebx, eax
+			_2A03_emit(t, 2, 0x31, 0xc3);
+			_2A03_emit_nz(t, _2A03_EBX);
+			break;
+
+		case OP_CMP:
+			_2A03_emit_compare(t, _2A03_EBX);
+			break;
+
+		case OP_CPX:
+			_2A03_emit_compare(t, _2A03_ESI);
+			break;
+
+		case OP_CPY:
+			_2A03_emit_compare(t, _2A03_EDI);
+			break;
+
+		case OP_BIT:
+			// and cl, ~(N | V | Z) / mov edx, eax / and dl, N | V / or cl, dl
+			_2A03_emit(t, 10, 0x80, 0xe1, (__UINT_8) ~(N | V | Z), 0x89, 0xc2, 0x80, 0xe2, N | V, 0x08, 0xd1);
+			// test bl, al / jnz $ + 3 / or cl, Z
+			_2A03_emit(t, 7, 0x84, 0xc3, 0x75, 0x03, 0x80, 0xc9, Z);
+			break;
+
+		case OP_ASL:
+			// and cl, ~(N | Z | C) / shl byte [edx], 1 / adc cl, 0
+			_2A03_emit(t, 8, 0x80, 0xe1, (__UINT_8) ~(N | Z | C), 0xd0, 0x22, 0x80, 0xd1, 0x00);
+			_2A03_emit_shift_flags(t);
+			break;
+
+		case OP_LSR:
+			// and cl, ~(N | Z | C) / shr byte [edx], 1 / adc cl, 0
+			_2A03_emit(t, 8, 0x80, 0xe1, (__UINT_8) ~(N | Z | C), 0xd0, 0x2a, 0x80, 0xd1, 0x00);
+			_2A03_emit_shift_flags(t);
+			break;
+
+		case OP_ROL:
+			// bt ecx, 0 / rcl byte [edx], 1 / setc al
+			_2A03_emit(t, 9, 0x0f, 0xba, 0xe1, 0x00, 0xd0, 0x12, 0x0f, 0x92, 0xc0);
+			// and cl, ~(N | Z | C) / or cl, al
+			_2A03_emit(t, 5, 0x80, 0xe1, (__UINT_8) ~(N | Z | C), 0x08, 0xc1);
+			_2A03_emit_shift_flags(t);
+			break;
+
+		case OP_ROR:
+			// bt ecx, 0 / rcr byte [edx], 1 / setc al
+			_2A03_emit(t, 9, 0x0f, 0xba, 0xe1, 0x00, 0xd0, 0x1a, 0x0f, 0x92, 0xc0);
+			// and cl, ~(N | Z | C) / or cl, al
+			_2A03_emit(t, 5, 0x80, 0xe1, (__UINT_8) ~(N | Z | C), 0x08, 0xc1);
+			_2A03_emit_shift_flags(t);
+			break;
+
+		case OP_INC:
+			// inc byte [edx] / and cl, ~(N | Z)
+			_2A03_emit(t, 5, 0xfe, 0x02, 0x80, 0xe1, (__UINT_8) ~(N | Z));
+			_2A03_emit_shift_flags(t);
+			break;
+
+		case OP_DEC:
+			// dec byte [edx] / and cl, ~(N | Z)
+			_2A03_emit(t, 5, 0xfe, 0x0a, 0x80, 0xe1, (__UINT_8) ~(N | Z));
+			_2A03_emit_shift_flags(t);
+			break;
+
+		case OP_ASLA:
+			// and cl, ~(N | Z | C) / shl bl, 1 / adc cl, 0
+			_2A03_emit(t, 8, 0x80, 0xe1, (__UINT_8) ~(N | Z | C), 0xd0, 0xe3, 0x80, 0xd1, 0x00);
+			_2A03_emit(t, 2, 0x0a, 0x8b);
+			_2A03_emit_address(t, _2A03_nz_flags);
+			break;
+
+		case OP_LSRA:
+			// and cl, ~(N | Z | C) / shr bl, 1 / adc cl, 0
+			_2A03_emit(t, 8, 0x80, 0xe1, (__UINT_8) ~(N | Z | C), 0xd0, 0xeb, 0x80, 0xd1, 0x00);
+			_2A03_emit(t, 2, 0x0a, 0x8b);
+			_2A03_emit_address(t, _2A03_nz_flags);
+			break;
+
+		case OP_ROLA:
+			// bt ecx, 0 / rcl bl, 1 / setc dl
+			_2A03_emit(t, 9, 0x0f, 0xba, 0xe1, 0x00, 0xd0, 0xd3, 0x0f, 0x92, 0xc2);
+			// and cl, ~(N | Z | C) / or cl, dl
+			_2A03_emit(t, 5, 0x80, 0xe1, (__UINT_8) ~(N | Z | C), 0x08, 0xd1);
+			_2A03_emit(t, 2, 0x0a, 0x8b);
+			_2A03_emit_address(t, _2A03_nz_flags);
+			break;
+
+		case OP_RORA:
+			// bt ecx, 0 / rcr bl, 1 / setc dl
+			_2A03_emit(t, 9, 0x0f, 0xba, 0xe1, 0x00, 0xd0, 0xdb, 0x0f, 0x92, 0xc2);
+			// and cl, ~(N | Z | C) / or cl, dl
+			_2A03_emit(t, 5, 0x80, 0xe1, (__UINT_8) ~(N | Z | C), 0x08, 0xd1);
+			_2A03_emit(t, 2, 0x0a, 0x8b);
+			_2A03_emit_address(t, _2A03_nz_flags);
+			break;
+
+		case OP_INX:
+		case OP_DEX:
+			// inc / dec esi / and esi, 0xff
+			_2A03_emit(t, 7, operation == OP_INX ? 0x46 : 0x4e, 0x81, 0xe6, 0xff, 0x00, 0x00, 0x00);
+			_2A03_emit_nz(t, _2A03_ESI);
+			break;
+
+		case OP_INY:
+		case OP_DEY:
+			// inc / dec edi / and edi, 0xff
+			_2A03_emit(t, 7, operation == OP_INY ? 0x47 : 0x4f, 0x81, 0xe7, 0xff, 0x00, 0x00, 0x00);
+			_2A03_emit_nz(t, _2A03_EDI);
+			break;
+
+		case OP_TAX:
+			// mov esi, ebx
+			_2A03_emit(t, 2, 0x89, 0xde);
+			_2A03_emit_nz(t, _2A03_ESI);
+			break;
+
+		case OP_TAY:
+			// mov edi, ebx
+			_2A03_emit(t, 2, 0x89, 0xdf);
+			_2A03_emit_nz(t, _2A03_EDI);
+			break;
+
+		case OP_TXA:
+			// mov ebx, esi
+			_2A03_emit(t, 2, 0x89, 0xf3);
+			_2A03_emit_nz(t, _2A03_EBX);
+			break;
+
+		case OP_TYA:
+			// mov ebx, edi
+			_2A03_emit(t, 2, 0x89, 0xfb);
+			_2A03_emit_nz(t, _2A03_EBX);
+			break;
+
+		case OP_TSX:
+			// movzx esi, byte [SP]
+			_2A03_emit(t, 3, 0x0f, 0xb6, 0x35);
+			_2A03_emit_address(t, &t->context->SP);
+			_2A03_emit_nz(t, _2A03_ESI);
+			break;
+
+		case OP_TXS:
+			// mov eax, esi / mov [SP], al
+			_2A03_emit(t, 3, 0x89, 0xf0, 0xa2);
+			_2A03_emit_address(t, &t->context->SP);
+			break;
+
+		case OP_PHA:
+		case OP_PHP:
+			_2A03_emit_load_sp(t);
+			if(operation == OP_PHP)
+			{
+				// or cl, B / mov [edx + stack], cl
+				_2A03_emit(t, 5, 0x80, 0xc9, FLAG_B, 0x88, 0x8a);
+			}
+			else
+			{
+				// mov [edx + stack], bl
+				_2A03_emit(t, 2, 0x88, 0x9a);
+			}
+			_2A03_emit_address(t, dynarec->ram + 0x100);
+			// dec dl
+			_2A03_emit(t, 2, 0xfe, 0xca);
+			_2A03_emit_store_sp(t);
+			break;
+
+		case OP_PLA:
+			_2A03_emit_load_sp(t);
+			// inc dl / movzx ebx, byte [edx + stack]
+			_2A03_emit(t, 5, 0xfe, 0xc2, 0x0f, 0xb6, 0x9a);
+			_2A03_emit_address(t, dynarec->ram + 0x100);
+			_2A03_emit_store_sp(t);
+			_2A03_emit_nz(t, _2A03_EBX);
+			break;
+
+		case OP_CLC:
+			// and cl, ~C
+			_2A03_emit(t, 3, 0x80, 0xe1, (__UINT_8) ~C);
+			break;
+
+		case OP_SEC:
+			// or cl, C
+			_2A03_emit(t, 3, 0x80, 0xc9, C);
+			break;
+
+		case OP_CLD:
+			// and cl, ~D
+			_2A03_emit(t, 3, 0x80, 0xe1, (__UINT_8) ~D);
+			break;
+
+		case OP_CLV:
+			// and cl, ~V
+			_2A03_emit(t, 3, 0x80, 0xe1, (__UINT_8) ~V);
+			break;
+
+		// The interrupts can only be masked here
+		case OP_SEI:
+			// or cl, I
+			_2A03_emit(t, 3, 0x80, 0xc9, I);
+			break;
+
+		case OP_NOP:
+			break;
+
+		case OP_BRANCH:
+		{
+			static const __UINT_8 flags[4] = { N, V, C, Z };
+			register int taken = t->pc + 1 + (INT_8) operand + 1;
+			register __UINT_16 next = t->pc + 2;
+
+			// test cl, flag / jz or jnz taken
+			_2A03_emit(t, 3, 0xf6, 0xc1, flags[opcode >> 6]);
+			_2A03_jump_exit(t, (opcode & 0x20) ? _2A03_JNZ : _2A03_JZ, (__UINT_16) taken, t->index + 1,
+			                ((taken >> 8) != (next >> 8)) ? _2A03_FIX_CYCLES(2) : _2A03_FIX_CYCLES(1));
+			break;
+		}
+
+		case OP_JSR:
+			target = t->pc + 2;
+			_2A03_emit_load_sp(t);
+			_2A03_emit_push_value(t, (__UINT_8) (target >> 8));
+			_2A03_emit_push_value(t, (__UINT_8) target);
+			_2A03_emit_store_sp(t);
+			// (no break)
+		case OP_JMP:
+			_2A03_jump_exit(t, _2A03_JMP, operand, t->index + 1, 0);
+			*last = TRUE;
+			break;
+
+		case OP_RTS:
+			_2A03_emit_load_sp(t);
+			// inc dl / movzx eax, byte [edx + stack]
+			_2A03_emit(t, 5, 0xfe, 0xc2, 0x0f, 0xb6, 0x82);
+			_2A03_emit_address(t, dynarec->ram + 0x100);
+			// inc dl / mov ah, [edx + stack]
+			_2A03_emit(t, 4, 0xfe, 0xc2, 0x8a, 0xa2);
+			_2A03_emit_address(t, dynarec->ram + 0x100);
+			_2A03_emit_store_sp(t);
+			// inc eax / mov [PC], ax
+			_2A03_emit(t, 3, 0x40, 0x66, 0xa3);
+			_2A03_emit_address(t, &t->context->PC.W);
+			_2A03_jump_exit(t, _2A03_JMP, -1, t->index + 1, 0);
+			*last = TRUE;
+			break;
+	}
+	return size;
+}
+
+// A load followed by a branch back to it may be an idle loop,
+// the interpreter spots these one instruction at a time
+static __BOOL _2A03_is_loop_head(__UINT_16 address, const __UINT_8 *code, int length)
+{
+	register int size;
+
+	switch(code[0])
+	{
+		case 0xa5:
+		case 0xa6:
+		case 0xa4:
+		case 0x24:
+			size = 2;
+			break;
+
+		case 0xad:
+		case 0xae:
+		case 0xac:
+		case 0x2c:
+			size = 3;
+			break;
+
+		default:
+			return FALSE;
+	}
+	return (size + 2 <= length) && ((code[size] & 0x1f) == 0x10) &&
+		   ((__UINT_16) (address + size + 2 + (INT_8) code[size + 1]) == address);
+}
+
+/******************************************************************************/
+/** Blocks                                                                   **/
+/******************************************************************************/
+
+void _2A03_dynarec_init(s_2A03_context *context, __UINT_8 **read_pages, __UINT_8 **write_pages, __UINT_8 *ram)
+{
+	s_2A03_translation t;
+	register s_2A03_dynarec *dynarec;
+	register int i;
+
+	for(i = 0; i < 0x100; i++)
+	{
+		_2A03_nz_flags[i] = (i & BIT_7) ? N : (i ? 0 : Z);
+	}
+
+	context->dynarec = NULL;
+	__NEW(dynarec, s_2A03_dynarec);
+	dynarec->code = (__UINT_8 *) VirtualAlloc(NULL, _2A03_CODE_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+	if(!dynarec->code)
+	{
+		// Everything runs interpreted
+		__DELETE(dynarec);
+		return;
+	}
+	dynarec->read_pages = read_pages;
+	dynarec->write_pages = write_pages;
+	dynarec->ram = ram;
+
+	t.context = context;
+	t.dynarec = dynarec;
+	t.out = dynarec->code;
+	_2A03_emit_exit_code(&t);
+	dynarec->exit_size = _2A03_ALIGN(t.out - dynarec->code);
+	dynarec->used = dynarec->exit_size;
+	context->dynarec = dynarec;
+}
+
+void _2A03_dynarec_free(s_2A03_context *context)
+{
+	if(context->dynarec)
+	{
+		VirtualFree(context->dynarec->code, 0, MEM_RELEASE);
+		__DELETE(context->dynarec);
+	}
+}
+
+// Forgets all the blocks
+void _2A03_dynarec_flush(s_2A03_context *context)
+{
+	register int i;
+
+	if(!context->dynarec)
+	{
+		return;
+	}
+	for(i = 0; i < context->decoded_size; i++)
+	{
+		context->decoded[i].block = NULL;
+	}
+	context->dynarec->used = context->dynarec->exit_size;
+}
+
+// Translates the code found at address (length bytes can be read from
+// there), the block has no code if the interpreter has to run the first
+// instruction
+s_2A03_block *_2A03_dynarec_translate(s_2A03_context *context, __UINT_16 address, const __UINT_8 *code, int length)
+{
+	s_2A03_translation t;
+	register s_2A03_dynarec *dynarec = context->dynarec;
+	register s_2A03_block *block;
+	register __UINT_8 *entry;
+	register int size;
+	__BOOL last = FALSE;
+	int offset = 0;
+
+	if(dynarec->used + _2A03_BLOCK_ROOM > _2A03_CODE_SIZE)
+	{
+		_2A03_dynarec_flush(context);
+	}
+	block = (s_2A03_block *) (dynarec->code + dynarec->used);
+	block->address = address;
+	block->run = NULL;
+	dynarec->used += _2A03_ALIGN(sizeof(s_2A03_block));
+	if(_2A03_is_loop_head(address, code, length))
+	{
+		return block;
+	}
+
+	t.context = context;
+	t.dynarec = dynarec;
+	t.out = entry = dynarec->code + dynarec->used;
+	t.nbr_exits = 0;
+	_2A03_emit_entry(&t);
+	for(t.index = 0; t.index < _2A03_BLOCK_INSTRUCTIONS && !last; t.index++)
+	{
+		t.pc = address + offset;
+		size = _2A03_translate_instruction(&t, code + offset, length - offset, &last);
+		if(!size)
+		{
+			break;
+		}
+		offset += size;
+	}
+	if(!t.index)
+	{
+		return block;
+	}
+	if(!last)
+	{
+		_2A03_jump_exit(&t, _2A03_JMP, (__UINT_16) (address + offset), t.index, 0);
+	}
+	_2A03_emit_exits(&t);
+
+	block->run = (int (*) (void)) entry;
+	dynarec->used = _2A03_ALIGN(t.out - dynarec->code);
+	return block;
+}
+
+#endif
@@ -0,0 +1,101 @@
+/*******************************************************************************
+    crudNES - A NES emulator for reverse engineering purposes
+    Code/Data Logger
+    Copyright (C) 2023-2024 Franck "hitchhikr" Charlet
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "include/c_code_data_log.h"
+
+/******************************************************************************/
+/** Installer                                                                **/
+/******************************************************************************/
+
+c_code_data_log :: c_code_data_log (__INT_32 prg_rom_size, __INT_32 chr_rom_size)
+{
+	prg_size = prg_rom_size;
+	chr_size = chr_rom_size;
+
+	// Both maps are stored back to back, the same way they're written
+	__NEW_MEM_BLOCK (prg, __UINT_8, prg_size + chr_size + 1);
+	memset (prg, 0, prg_size + chr_size + 1);
+	chr = prg + prg_size;
+}
+
+/******************************************************************************/
+/** Uninstaller                                                              **/
+/******************************************************************************/
+
+c_code_data_log :: ~c_code_data_log (void)
+{
+	__DELETE_MEM_BLOCK (prg);
+}
+
+/******************************************************************************/
+/** load ()                                                                  **/
+/**                                                                          **/
+/** Merges a previously saved log into the current one so that the coverage **/
+/** of several runs accumulates.                                             **/
+/******************************************************************************/
+
+void c_code_data_log :: load (const char *filename)
+{
+	__UINT_8 *previous;
+	__INT_32 size = prg_size + chr_size;
+	__INT_32 i;
+
+	FILE *in = fopen (filename, "rb");
+	if (!in)
+	{
+		return;
+	}
+	fseek (in, 0, SEEK_END);
+	// Don't merge logs made with another rom
+	if (ftell (in) != size)
+	{
+		fclose (in);
+		return;
+	}
+	fseek (in, 0, SEEK_SET);
+
+	__NEW_MEM_BLOCK (previous, __UINT_8, size + 1);
+	if (fread (previous, 1, size, in) == (size_t) size)
+	{
+		for (i = 0; i < size; i++)
+		{
+			prg [i] |= previous [i];
+		}
+	}
+	__DELETE_MEM_BLOCK (previous);
+	fclose (in);
+}
+
+/******************************************************************************/
+/** save ()                                                                  **/
+/******************************************************************************/
+
+void c_code_data_log :: save (const char *filename)
+{
+	FILE *out = fopen (filename, "wb");
+	if (out)
+	{
+		fwrite (prg, 1, prg_size + chr_size, out);
+		fclose (out);
+	}
+}
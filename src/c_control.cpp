@@ -21,6 +21,7 @@
 
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "include/c_control.h"
@@ -35,18 +36,32 @@
 /** External Data                                                            **/
 /******************************************************************************/
 
-extern c_machine *o_machine;
+extern __THREAD_LOCAL c_machine *o_machine;
 extern int nbr_genies_6;
 extern GENIE_6 genies_6[1024];
 extern int nbr_genies_8;
 extern GENIE_8 genies_8[1024];
 
+static int compare_genie_patches (const void *a, const void *b)
+{
+    const s_genie_patch *patch_a = (const s_genie_patch *) a;
+    const s_genie_patch *patch_b = (const s_genie_patch *) b;
+
+    if (patch_a->address != patch_b->address)
+    {
+        return patch_a->address - patch_b->address;
+    }
+    return patch_a->order - patch_b->order;
+}
+
 /******************************************************************************/
 /** Installer                                                                **/
 /******************************************************************************/
 
 c_nes_control :: c_nes_control (void)
 {
+    int i;
+
     __DBG_INSTALLING ("Multi-Hardware Controller");
 
     __NEW_MEM_BLOCK (control [APU], __UINT_8, 0x18);
@@ -55,6 +70,31 @@ c_nes_control :: c_nes_control (void)
     memset (control [APU], 0, 0x18);
     memset (control [DMA], 0, 0x01);
 
+    memset (read_pages, 0, sizeof (read_pages));
+    memset (write_pages, 0, sizeof (write_pages));
+    memset (genie_pages, 0, sizeof (genie_pages));
+    memset (genie_bits, 0, sizeof (genie_bits));
+    genie_patches = NULL;
+    nbr_genie_patches = 0;
+
+    // The 2k of RAM are mirrored up to 0x1fff
+    for (i = 0x00; i < 0x20; i++)
+    {
+        read_pages [i] = &(*nes->o_ram) [(i & 7) << 8];
+        write_pages [i] = read_pages [i];
+    }
+    // SRAM writes are left to the mappers
+    for (i = 0x60; i < 0x80; i++)
+    {
+        read_pages [i] = &(*nes->o_sram) [(i - 0x60) << 8];
+    }
+
+    // The PRG-ROM pages are mapped by the cpu
+    if (nbr_genies_6 || nbr_genies_8)
+    {
+        build_genie_patches ();
+    }
+
     __DBG_INSTALLED ();
 }
 
@@ -68,48 +108,122 @@ c_nes_control :: ~c_nes_control (void)
 
     __DELETE_MEM_BLOCK (control [APU]);
     __DELETE_MEM_BLOCK (control [DMA]);
+    __DELETE_MEM_BLOCK (genie_patches);
 
     __DBG_UNINSTALLED ();
 }
 
 /******************************************************************************/
-/** read_byte ()                                                              **/
+/** build_genie_patches ()                                                   **/
+/**                                                                          **/
+/** Merges the 6 and 8 characters codes into a single table sorted by       **/
+/** address, the first code given for an address wins (6 characters first). **/
 /******************************************************************************/
 
-__UINT_8 c_nes_control :: read_byte (__UINT_16 address)
+void c_nes_control :: build_genie_patches (void)
 {
     int i;
+    int j;
 
-    if (address > 0x7fff)
+    __NEW_MEM_BLOCK (genie_patches, s_genie_patch, nbr_genies_6 + nbr_genies_8);
+    for (i = 0; i < nbr_genies_6; i++)
     {
-            if(nbr_genies_6)
-            {
-                for(i = 0; i < nbr_genies_6; i++)
-                {
-                    if(genies_6[i].address.W == address)
-                    {
-                        return genies_6[i].data;
-                    }
-                }
-            }
-            if(nbr_genies_8)
+        genie_patches [i].address = genies_6[i].address.W;
+        genie_patches [i].data = genies_6[i].data;
+        genie_patches [i].compare = 0;
+        genie_patches [i].has_compare = FALSE;
+        genie_patches [i].order = i;
+    }
+    for (j = 0; j < nbr_genies_8; j++, i++)
+    {
+        genie_patches [i].address = genies_8[j].address.W;
+        genie_patches [i].data = genies_8[j].data;
+        genie_patches [i].compare = genies_8[j].compare;
+        genie_patches [i].has_compare = TRUE;
+        genie_patches [i].order = i;
+    }
+    qsort (genie_patches, i, sizeof (s_genie_patch), compare_genie_patches);
+
+    // Keep one patch per address
+    nbr_genie_patches = 0;
+    for (j = 0; j < i; j++)
+    {
+        if (nbr_genie_patches && genie_patches [nbr_genie_patches - 1].address == genie_patches [j].address)
+        {
+            continue;
+        }
+        genie_patches [nbr_genie_patches++] = genie_patches [j];
+        genie_bits [(genie_patches [j].address & 0x7fff) >> 3] |= 1 << (genie_patches [j].address & 7);
+        genie_pages [genie_patches [j].address >> 8] = TRUE;
+    }
+}
+
+/******************************************************************************/
+/** read_genie ()                                                            **/
+/******************************************************************************/
+
+__UINT_8 c_nes_control :: read_genie (__UINT_16 address)
+{
+    int lo = 0;
+    int hi = nbr_genie_patches - 1;
+    int mid;
+
+    while (lo <= hi)
+    {
+        mid = (lo + hi) >> 1;
+        if (genie_patches [mid].address == address)
+        {
+            // The compare value is only checked on a hit
+            if (genie_patches [mid].has_compare &&
+                nes->o_cpu->read_byte (address) != genie_patches [mid].compare)
             {
-                for(i = 0; i < nbr_genies_8; i++)
-                {
-                    if(genies_8[i].address.W == address)
-                    {
-                        if(nes->o_cpu->read_byte (address) == genies_8[i].compare)
-                        {
-                            return genies_8[i].data;
-                        }
-                        else
-                        {
-                            return nes->o_cpu->read_byte (address);
-                        }
-                    }
-                }
+                break;
             }
-            return nes->o_cpu->read_byte (address);
+            return genie_patches [mid].data;
+        }
+        if (genie_patches [mid].address < address)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid - 1;
+        }
+    }
+    return nes->o_cpu->read_byte (address);
+}
+
+/******************************************************************************/
+/** map_prg_window ()                                                        **/
+/**                                                                          **/
+/** Called by the cpu each time a 4k window of the PRG-ROM is swapped.      **/
+/******************************************************************************/
+
+void c_nes_control :: map_prg_window (__UINT_8 window, __UINT_8 *source)
+{
+    int i;
+    int page = 0x80 + (window << 4);
+
+    for (i = 0; i < 0x10; i++)
+    {
+        // The genies are checked by read_unmapped ()
+        read_pages [page + i] = genie_pages [page + i] ? NULL : source + (i << 8);
+    }
+}
+
+/******************************************************************************/
+/** read_unmapped ()                                                         **/
+/******************************************************************************/
+
+__UINT_8 c_nes_control :: read_unmapped (__UINT_16 address)
+{
+    if (address > 0x7fff)
+    {
+        if (genie_bits [(address & 0x7fff) >> 3] & (1 << (address & 7)))
+        {
+            return read_genie (address);
+        }
+        return nes->o_cpu->read_byte (address);
     }
     if (address < 0x2000)
     {
@@ -148,10 +262,10 @@ __UINT_16 c_nes_control :: read_word (__UINT_16 address)
 }
 
 /******************************************************************************/
-/** write_byte ()                                                             **/
+/** write_unmapped ()                                                        **/
 /******************************************************************************/
 
-void c_nes_control :: write_byte (__UINT_16 address, __UINT_8 value)
+void c_nes_control :: write_unmapped (__UINT_16 address, __UINT_8 value)
 {
     if (address < 0x2000)
     {
@@ -25,7 +25,9 @@
 #include <string.h>
 
 #include "include/2a03.h"
+#include "include/2a03_dynarec.h"
 #include "include/c_cpu.h"
+#include "include/c_control.h"
 #include "include/c_ppu.h"
 #include "include/c_rom.h"
 #include "include/mappers/c_mapper.h"
@@ -38,7 +40,7 @@
 /** External Data                                                            **/
 /******************************************************************************/
 
-extern c_machine *o_machine;
+extern __THREAD_LOCAL c_machine *o_machine;
 
 /******************************************************************************/
 /** irq_notifier ()                                                            **/
@@ -60,6 +62,10 @@ void irq_notifier (void *)
 int dmc_reader (void *, unsigned address)
 {
 	_2A03_kill_cycles (4*3*(!nes->o_cpu->is_pal () ? 16: 15));
+	if (_2A03_get_label_holder ())
+	{
+		nes->o_cdl->log_prg (nes->o_cpu->get_rom_offset (address), address, CDL_PRG_DATA | CDL_PRG_PCM);
+	}
 	return nes->o_cpu->read_byte (address);
 }
 
@@ -71,10 +77,26 @@ c_nes_cpu :: c_nes_cpu (void)
 {
 	__DBG_INSTALLING ("CPU");
 
+	// The core runs this machine from now on (in this thread)
+	_2A03_init_context (&context);
+	_2A03_set_context (&context);
+
 	PRGROM.resize (nes->o_rom->information ().prg_pages * _16K_);
 	nes->o_rom->transfer_block (&PRGROM [0], 0x10, nes->o_rom->information ().prg_pages * _16K_);
 
 	memset (pages, 0x00, sizeof(pages));
+	cycle_multiplier = 16;
+	held_time = -1;
+
+	context.decoded_size = PRGROM.get_size ();
+	__NEW_MEM_BLOCK (context.decoded, s_2A03_decoded, context.decoded_size);
+	memset (context.decoded, 0, context.decoded_size * sizeof (s_2A03_decoded));
+	// The interpreter runs everything unless the translator was asked for
+	if (nes->is_dynarec_on ())
+	{
+		_2A03_dynarec_init (&context, nes->o_control->get_read_pages (),
+		                    nes->o_control->get_write_pages (), &(*nes->o_ram) [0]);
+	}
 
 	nes->o_rom->HEADER.resize (0x10);
 	nes->o_rom->ROM.resize ((nes->o_rom->information ().prg_pages * _16K_) +
@@ -103,6 +125,9 @@ c_nes_cpu :: ~c_nes_cpu (void)
     {
 		stop_audio_stream (audio_stream);
     }
+	_2A03_set_context (NULL);
+	_2A03_dynarec_free (&context);
+	__DELETE_MEM_BLOCK (context.decoded);
 	__DBG_UNINSTALLED ();
 }
 
@@ -113,6 +138,7 @@ c_nes_cpu :: ~c_nes_cpu (void)
 void c_nes_cpu :: reset (void)
 {
 	ideal_time = 0;
+	held_time = -1;
 	event_taking_place = FALSE;
 	is_frame_even = FALSE;
 
@@ -136,23 +162,29 @@ __INT_32 c_nes_cpu :: earliest_event_before (__INT_32 iEndTime)
 	if (!_2A03_get_interrupt_flag ())
 	{
 		__INT_32 irq_time = nes->o_apu.earliest_irq ();
-		if (irq_time < 0x2aaaaaaa && ((irq_time * 3 * ((!pal_console)?16:15)) <= iEndTime))
+		if (irq_time < 0x2aaaaaaa && ((irq_time * 3 * (__INT_32) cycle_multiplier) <= iEndTime))
         {
-            iEndTime = irq_time * 3 * ((!pal_console)?16:15);
+            iEndTime = irq_time * 3 * cycle_multiplier;
         }
 	}
 
 	return iEndTime;
 }
 
-void c_nes_cpu :: run_cycles (__INT_32 cycles)
+/******************************************************************************/
+/** run_until ()                                                             **/
+/**                                                                          **/
+/** Runs the cpu from one event (apu irq) to the next until it reaches the  **/
+/** given time (the time of the PPU unless it's running ahead).             **/
+/******************************************************************************/
+
+void c_nes_cpu :: run_until (__INT_32 time)
 {
-	if (!pal_console) ideal_time += cycles * 16;
-	else ideal_time += cycles * 15;
+	__BOOL is_ahead = _2A03_is_running_ahead ();
 
-	while (_2A03_get_current_time () < ideal_time)
+	while (_2A03_get_current_time () < time)
 	{
-		_2A03_set_end_time (earliest_event_before (ideal_time));
+		_2A03_set_end_time (earliest_event_before (time));
 
 		if (_2A03_get_end_time () <= _2A03_get_current_time ())
 		{
@@ -160,13 +192,44 @@ void c_nes_cpu :: run_cycles (__INT_32 cycles)
             {
                 request_irq ();
             }
-			_2A03_set_end_time (ideal_time);
+			_2A03_set_end_time (time);
 		}
 
 		if (_2A03_has_enough_cycles ()) _2A03_run ();
+
+		// Stopped before an access
+		if (is_ahead && !_2A03_is_running_ahead ())
+		{
+			break;
+		}
 	}
 }
 
+/******************************************************************************/
+/** run_ahead ()                                                             **/
+/**                                                                          **/
+/** Lets the cpu run up to the time of the next event (mapper irq in hblank **/
+/** or end of the line) without waiting for the PPU. It stops before the    **/
+/** first access to the PPU or to the mapper, which are executed once the  **/
+/** PPU caught up through run_cycles ().                                     **/
+/******************************************************************************/
+
+void c_nes_cpu :: run_ahead (__INT_32 time)
+{
+	// Still waiting for the PPU
+	if (_2A03_get_current_time () >= time || _2A03_get_current_time () == held_time)
+	{
+		return;
+	}
+	_2A03_set_run_ahead (TRUE);
+	run_until (time);
+	if (!_2A03_is_running_ahead ())
+	{
+		held_time = _2A03_get_current_time ();
+	}
+	_2A03_set_run_ahead (FALSE);
+}
+
 /******************************************************************************/
 /** run_accurate ()                                                           **/
 /******************************************************************************/
@@ -203,8 +266,9 @@ void c_nes_cpu :: run_accurate (void)
 		//Scanline #0
 		if (is_logtracer_on ())
         {
-            nes->general_log.f_write ("s", "--------------------------------- PROCESSING *__NEW FRAME* -----------------------------------\r\n");
+            nes->instruction_trace.add_marker (TRACE_NEW_FRAME, 0);
         }
+		nes->general_log.flush ();
 
 		//New frame. Adjust a few flags.
 		nes->o_gfx->lock_buffer ();
@@ -218,7 +282,7 @@ void c_nes_cpu :: run_accurate (void)
 			//Clear the current Scanline if background rendering is disabled.
 			if (is_logtracer_on ())
             {
-                nes->general_log.f_write ("sds", "---------------------- PROCESSING *SCANLINE* #", nes->o_ppu->information ().scanline, " ---------------------\r\n");				
+                nes->instruction_trace.add_marker (TRACE_SCANLINE, nes->o_ppu->information ().scanline);
             }
 
 			nes->o_ppu->run_accurate ();
@@ -229,7 +293,7 @@ void c_nes_cpu :: run_accurate (void)
 		//Scanline #240
 		if (is_logtracer_on ())
         {
-            nes->general_log.f_write ("sds", "--------------------------------- PROCESSING *HBLANK* #", nes->o_ppu->information ().scanline, " ---------------------------------\r\n");
+            nes->instruction_trace.add_marker (TRACE_HBLANK, nes->o_ppu->information ().scanline);
         }
 		run_cycles (260);
 		nes->o_mapper->h_blank ();
@@ -242,7 +306,7 @@ void c_nes_cpu :: run_accurate (void)
 		//Scanline #241 - VBlank
 		if (is_logtracer_on ())
         {
-            nes->general_log.f_write ("s", "----------------------------------- PROCESSING *VBLANK* ------------------------------------\r\n");
+            nes->instruction_trace.add_marker (TRACE_VBLANK, 0);
         }
 		nes->o_ppu->information ().is_v_blank = TRUE;
 
@@ -265,7 +329,7 @@ void c_nes_cpu :: run_accurate (void)
 		{
 			if (is_logtracer_on ())
             {
-                nes->general_log.f_write ("sds", "------------------------------- PROCESSING *SCANLINE* #", nes->o_ppu->information ().scanline, " ---------------------------------\r\n");
+                nes->instruction_trace.add_marker (TRACE_SCANLINE, nes->o_ppu->information ().scanline);
             }
 			run_cycles (341);
 			nes->o_mapper->h_blank ();
@@ -275,7 +339,7 @@ void c_nes_cpu :: run_accurate (void)
 
 		if (is_logtracer_on ())
         {
-            nes->general_log.f_write ("sds", "------------------------------- PROCESSING *SCANLINE* #", nes->o_ppu->information ().scanline, " ---------------------------------\r\n");
+            nes->instruction_trace.add_marker (TRACE_SCANLINE, nes->o_ppu->information ().scanline);
         }
 		nes->o_ppu->end_frame ();
 		run_cycles (260);
@@ -388,6 +452,22 @@ void c_nes_cpu :: swap_page (__UINT_16 dest_where, __UINT_16 page_number, e_page
 		pages [6] = pages [bank] + 6;
 		pages [7] = pages [bank] + 7;
 	}
+	update_prg_mapping ();
+}
+
+/******************************************************************************/
+/** update_prg_mapping ()                                                    **/
+/******************************************************************************/
+
+void c_nes_cpu :: update_prg_mapping (void)
+{
+	__UINT_32 page;
+
+	// The memory controller reads the windows directly
+	for (page = 0; page < 8; page ++)
+	{
+		nes->o_control->map_prg_window (page, PRGRAM [page]);
+	}
 }
 
 /******************************************************************************/
@@ -426,8 +506,10 @@ void c_nes_cpu :: load_state (c_tracer &o_reader, e_save_state Type)
 			{
 				PRGRAM [uiPage] = &PRGROM [pages [uiPage] * _4K_];
             }
+			update_prg_mapping ();
 
 			_2A03_load_state (o_reader);
+			held_time = -1;
 			break;
 
 		case OTHER:
@@ -442,6 +524,8 @@ void c_nes_cpu :: load_config (void)
 
 	apu_irqs_enabled = 0;   //!bValue;
 	pal_console = nes->o_rom->information().pal;        //bValue;
+	// Master clock ticks per PPU cycle
+	cycle_multiplier = pal_console ? 15 : 16;
     sampling_rate = 1;
     bits_per_sample = 0;
 	set_label_holder(1);
@@ -38,7 +38,7 @@ __UINT_16 nes_palette [512];
 /** External Data                                                            **/
 /******************************************************************************/
 
-extern c_machine *o_machine;
+extern __THREAD_LOCAL c_machine *o_machine;
 extern c_nes_cpu *o_cpu;
 
 /******************************************************************************/
@@ -0,0 +1,170 @@
+/*******************************************************************************
+    crudNES - A NES emulator for reverse engineering purposes
+    Instructions Trace
+    Copyright (C) 2023-2024 Franck "hitchhikr" Charlet
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "include/c_instruction_trace.h"
+#include "include/c_tracer.h"
+#include "include/2a03.h"
+
+/******************************************************************************/
+/** Installer                                                                **/
+/******************************************************************************/
+
+c_instruction_trace :: c_instruction_trace (void)
+{
+	handle = NULL;
+	name [0] = 0;
+	records = NULL;
+	nbr_records = 0;
+	// The buffer is allocated by the first record
+	max_records = 0;
+}
+
+/******************************************************************************/
+/** Uninstaller                                                              **/
+/******************************************************************************/
+
+c_instruction_trace :: ~c_instruction_trace (void)
+{
+	close ();
+}
+
+void c_instruction_trace :: set_output_file (const char *filename)
+{
+	strncpy (name, filename, sizeof (name) - 1);
+	name [sizeof (name) - 1] = 0;
+}
+
+/******************************************************************************/
+/** flush ()                                                                 **/
+/**                                                                          **/
+/** The file is only created once the logger produced something.            **/
+/******************************************************************************/
+
+void c_instruction_trace :: flush (void)
+{
+	if (!records)
+	{
+		__NEW_MEM_BLOCK (records, s_trace_record, TRACE_BUFFER_RECORDS);
+		max_records = TRACE_BUFFER_RECORDS;
+	}
+	if (nbr_records)
+	{
+		if (!handle && name [0])
+		{
+			handle = fopen (name, "wb");
+		}
+		if (handle)
+		{
+			fwrite (records, sizeof (s_trace_record), nbr_records, handle);
+		}
+	}
+	nbr_records = 0;
+}
+
+void c_instruction_trace :: close (void)
+{
+	flush ();
+	if (handle)
+	{
+		fclose (handle);
+	}
+	handle = NULL;
+	__DELETE_MEM_BLOCK (records);
+	records = NULL;
+	max_records = 0;
+}
+
+/******************************************************************************/
+/** render_marker ()                                                         **/
+/******************************************************************************/
+
+void c_instruction_trace :: render_marker (c_tracer &out, s_trace_record *record)
+{
+	switch (record->kind)
+	{
+		case TRACE_NEW_FRAME:
+			out.f_write ("s", "--------------------------------- PROCESSING *__NEW FRAME* -----------------------------------\r\n");
+			break;
+
+		case TRACE_SCANLINE:
+			// (the lines after the vblank were shown wider)
+			if (record->pc > 240)
+			{
+				out.f_write ("sds", "------------------------------- PROCESSING *SCANLINE* #", (__UINT_32) record->pc, " ---------------------------------\r\n");
+			}
+			else
+			{
+				out.f_write ("sds", "---------------------- PROCESSING *SCANLINE* #", (__UINT_32) record->pc, " ---------------------\r\n");
+			}
+			break;
+
+		case TRACE_HBLANK:
+			out.f_write ("sds", "--------------------------------- PROCESSING *HBLANK* #", (__UINT_32) record->pc, " ---------------------------------\r\n");
+			break;
+
+		case TRACE_VBLANK:
+			out.f_write ("s", "----------------------------------- PROCESSING *VBLANK* ------------------------------------\r\n");
+			break;
+
+		case TRACE_NMI_VECTOR:
+			out.f_write ("sws", "NMI Vector: ", record->pc, "\r\n");
+			break;
+
+		case TRACE_RESET_VECTOR:
+			out.f_write ("sws", "Reset Vector: ", record->pc, "\r\n");
+			break;
+
+		case TRACE_IRQ_VECTOR:
+			out.f_write ("sws", "IRQ Vector: ", record->pc, "\r\n");
+			break;
+	}
+}
+
+/******************************************************************************/
+/** render ()                                                                **/
+/******************************************************************************/
+
+__BOOL c_instruction_trace :: render (const char *filename, const char *output)
+{
+	s_trace_record record;
+
+	FILE *in = fopen (filename, "rb");
+	if (!in)
+	{
+		return FALSE;
+	}
+	c_tracer out (output, __NEW);
+	while (fread (&record, sizeof (s_trace_record), 1, in) == 1)
+	{
+		if (record.kind == TRACE_INSTRUCTION)
+		{
+			_2A03_render_trace_record (out, &record);
+		}
+		else
+		{
+			render_marker (out, &record);
+		}
+	}
+	fclose (in);
+	return TRUE;
+}
@@ -19,8 +19,12 @@
     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 *******************************************************************************/
 
+#include <windows.h>
 #include <string.h>
 #include <stdlib.h>
+#include <ctype.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include "include/c_label_holder.h"
 #include "include/c_tracer.h"
@@ -33,51 +37,421 @@
 #include "include/c_nes.h"
 #include "include/clist.h"
 
-extern c_machine *o_machine;
-CList <char *> listing;
-extern int warnings;
+extern __THREAD_LOCAL c_machine *o_machine;
+extern __THREAD_LOCAL int warnings;
+
+// Returned by search_label() when nothing is found (it's modified)
+static __THREAD_LOCAL s_label_node unknown;
+
+// Set while the banks are disassembled in parallel, the threads can't
+// modify the labels and have to give up the bank if they need to
+static __THREAD_LOCAL int labels_locked;
+static __THREAD_LOCAL int labels_blocked;
+
+#define MAX_BANK_THREADS 32
+
+struct s_bank_job
+{
+	s_label_node *pages;
+	int bank;
+	int chr;
+	int complete;
+	int warnings;
+	// State of the labels when it was made
+	__UINT_32 label_changes;
+	int uses_vectors;
+	int round_vectors;
+	int vectors;
+	CList <char *> listing;
+};
+
+static int same_label_records(const s_label_record *rec_a, const s_label_record *rec_b)
+{
+	return rec_a->contents == rec_b->contents &&
+		   rec_a->alias == rec_b->alias &&
+		   rec_a->offset == rec_b->offset &&
+		   rec_a->real_bank == rec_b->real_bank &&
+		   rec_a->ref_bank == rec_b->ref_bank &&
+		   rec_a->type == rec_b->type &&
+		   rec_a->sub_type == rec_b->sub_type &&
+		   rec_a->jump_base_table == rec_b->jump_base_table;
+}
+
+// Order the records by contents so the duplicated lines end up side by side
+static int compare_label_records(const void *a, const void *b)
+{
+	const s_label_record *rec_a = *(const s_label_record **) a;
+	const s_label_record *rec_b = *(const s_label_record **) b;
+
+	if(rec_a->contents != rec_b->contents) return rec_a->contents - rec_b->contents;
+	if(rec_a->alias != rec_b->alias) return rec_a->alias - rec_b->alias;
+	if(rec_a->offset != rec_b->offset) return rec_a->offset < rec_b->offset ? -1 : 1;
+	if(rec_a->real_bank != rec_b->real_bank) return rec_a->real_bank - rec_b->real_bank;
+	if(rec_a->ref_bank != rec_b->ref_bank) return rec_a->ref_bank - rec_b->ref_bank;
+	if(rec_a->type != rec_b->type) return rec_a->type - rec_b->type;
+	if(rec_a->sub_type != rec_b->sub_type) return rec_a->sub_type - rec_b->sub_type;
+	if(rec_a->jump_base_table != rec_b->jump_base_table) return rec_a->jump_base_table - rec_b->jump_base_table;
+	// Keep the file order between identical lines
+	return (int) (rec_a - rec_b);
+}
+
+// The machine is per thread
+static DWORD WINAPI label_events_thread(LPVOID holder)
+{
+	o_machine = ((c_label_holder *) holder)->get_machine();
+	((c_label_holder *) holder)->process_events();
+	return 0;
+}
+
+static DWORD WINAPI bank_jobs_thread(LPVOID holder)
+{
+	o_machine = ((c_label_holder *) holder)->get_machine();
+	((c_label_holder *) holder)->run_bank_jobs();
+	return 0;
+}
+
+static int labels_frozen(void)
+{
+	if(labels_locked)
+	{
+		labels_blocked = TRUE;
+		return TRUE;
+	}
+	return FALSE;
+}
 
 c_label_holder :: c_label_holder (void)
+{
+	// For the threads
+	machine = o_machine;
+    head = NULL;
+    tail = NULL;
+	__NEW_MEM_BLOCK(address_heads, s_label_node *, 0x10000);
+	__NEW_MEM_BLOCK(address_tails, s_label_node *, 0x10000);
+	memset(address_heads, 0, 0x10000 * sizeof(s_label_node *));
+	memset(address_tails, 0, 0x10000 * sizeof(s_label_node *));
+	page_tables = FALSE;
+	alias_pages = NULL;
+	alias_slots = NULL;
+	changed_address = 0;
+	changed_alias = -1;
+	label_changes = 0;
+	bank_jobs = NULL;
+
+	prg_size = nes->o_cpu->PRGROM.get_size();
+	__NEW_MEM_BLOCK(visited_sites, __UINT_8, prg_size);
+	__NEW_MEM_BLOCK(visited_keys, __UINT_32, prg_size * 2);
+	memset(visited_sites, 0, prg_size);
+	memset(visited_keys, 0, prg_size * 2 * sizeof(__UINT_32));
+
+    // Load all the labels
+	if(!load_labels_db())
+	{
+		load_labels_text();
+	}
+
+	events = NULL;
+	events_thread = NULL;
+	events_posted = NULL;
+	events_freed = NULL;
+}
+
+// Dump all labels before closing
+c_label_holder :: ~c_label_holder (void)
+{
+	flush_labels();
+	__DELETE_MEM_BLOCK(events);
+	__DELETE_MEM_BLOCK(address_heads);
+	__DELETE_MEM_BLOCK(address_tails);
+	__DELETE_MEM_BLOCK(visited_sites);
+	__DELETE_MEM_BLOCK(visited_keys);
+	free_page_tables();
+}
+
+// Check if an instruction already reported that kind of label.
+// Its operands are in rom so the label only depends on the page
+// backing the target and on the bank numbers of the target and
+// of the instruction (see insert_label ())
+int c_label_holder::is_new_site(__UINT_16 address, int kind, __UINT_16 target)
+{
+	int offset;
+	int slot;
+	int slot_kinds;
+	__UINT_32 key;
+
+	// (the operands of the last instruction of a window are in the next one)
+	if(address <= 0x7fff || (address & 0xfff) > 0xffd)
+	{
+		return TRUE;
+	}
+	offset = nes->o_cpu->get_rom_offset(address);
+	if(offset < 0 || offset >= prg_size)
+	{
+		return TRUE;
+	}
+	key = (target > 0x7fff) ? ((__UINT_32) nes->o_cpu->get_rom_offset(target) >> 12) << 16 : 0xffff0000;
+	key |= (nes->o_mapper->get_real_prg_bank_number(target) << 8) | nes->o_mapper->get_real_prg_bank_number(address);
+
+	// The return address of a jump has its own key
+	if(kind == SITE_END)
+	{
+		slot = (offset << 1) + 1;
+		slot_kinds = SITE_END;
+	}
+	else
+	{
+		slot = offset << 1;
+		slot_kinds = SITE_DATA | SITE_BRANCH | SITE_JUMP | SITE_POINTER;
+	}
+	if(visited_keys[slot] != key)
+	{
+		visited_keys[slot] = key;
+		visited_sites[offset] &= ~slot_kinds;
+	}
+	if(visited_sites[offset] & kind)
+	{
+		return FALSE;
+	}
+	visited_sites[offset] |= kind;
+	return TRUE;
+}
+
+// Wait for the labels thread to insert everything it was sent
+void c_label_holder::flush_labels(void)
+{
+	if(events_thread)
+	{
+		events_stop = TRUE;
+		SetEvent((HANDLE) events_posted);
+		WaitForSingleObject((HANDLE) events_thread, INFINITE);
+		CloseHandle((HANDLE) events_thread);
+		events_thread = NULL;
+	}
+	if(events_posted)
+	{
+		CloseHandle((HANDLE) events_posted);
+		events_posted = NULL;
+	}
+	if(events_freed)
+	{
+		CloseHandle((HANDLE) events_freed);
+		events_freed = NULL;
+	}
+}
+
+// Labels thread
+void c_label_holder::process_events(void)
+{
+	__UINT_32 last;
+	__UINT_32 stop;
+
+	for(;;)
+	{
+		// Everything was sent before the stop request
+		stop = events_stop;
+		last = events_write;
+		if(events_read == last)
+		{
+			if(stop)
+			{
+				break;
+			}
+			// Sleep until something is posted, if a post misses the flag
+			// the next one (or the stop request) wakes the thread up
+			events_idle = TRUE;
+			MemoryBarrier();
+			if(events_write == last && !events_stop)
+			{
+				WaitForSingleObject((HANDLE) events_posted, INFINITE);
+			}
+			events_idle = FALSE;
+			continue;
+		}
+		while(events_read != last)
+		{
+			apply_event(&events[events_read & (LABEL_EVENTS_SIZE - 1)]);
+			events_read = events_read + 1;
+		}
+		// Wake the emulation up if it's waiting for room
+		MemoryBarrier();
+		if(events_full)
+		{
+			events_full = FALSE;
+			SetEvent((HANDLE) events_freed);
+		}
+	}
+}
+
+// Labels are inserted directly if the thread can't be started
+void c_label_holder::start_events(void)
+{
+	events_read = 0;
+	events_write = 0;
+	events_stop = FALSE;
+	events_idle = FALSE;
+	events_full = FALSE;
+	__NEW_MEM_BLOCK(events, s_label_event, LABEL_EVENTS_SIZE);
+	events_posted = CreateEventA(NULL, FALSE, FALSE, NULL);
+	events_freed = CreateEventA(NULL, FALSE, FALSE, NULL);
+	if(events_posted && events_freed)
+	{
+		events_thread = CreateThread(NULL, 0, label_events_thread, this, 0, NULL);
+	}
+}
+
+void c_label_holder::post_event(s_label_event *event)
+{
+	__UINT_32 index;
+
+	if(!events)
+	{
+		start_events();
+	}
+	if(!events_thread)
+	{
+		apply_event(event);
+		return;
+	}
+	index = events_write;
+	// Queue is full
+	while((index - events_read) >= LABEL_EVENTS_SIZE)
+	{
+		events_full = TRUE;
+		MemoryBarrier();
+		if((index - events_read) >= LABEL_EVENTS_SIZE)
+		{
+			WaitForSingleObject((HANDLE) events_freed, INFINITE);
+		}
+	}
+	events[index & (LABEL_EVENTS_SIZE - 1)] = *event;
+	// Volatile stores are ordered (the slot is written before it's published)
+	events_write = index + 1;
+	if(events_idle)
+	{
+		SetEvent((HANDLE) events_posted);
+	}
+}
+
+void c_label_holder::apply_event(s_label_event *event)
+{
+	switch(event->kind)
+	{
+		case EVENT_LABEL:
+			add_label(event->value, (e_dattype) event->type, (e_dattype) event->sub_type,
+			          event->force, event->base, event->ref_bank, event->bank, event->offset);
+			break;
+
+		case EVENT_LABEL_BANK:
+			insert_label_bank(event->bank, event->value, (e_dattype) event->type, (e_dattype) event->sub_type,
+			                  event->force, event->base, event->ref_bank, event->offset, event->old_bank);
+			break;
+	}
+}
+
+// Append a label to the list and to the chain of its address
+void c_label_holder::link_label(s_label_node *label)
+{
+	if(tail)
+	{
+		tail->Next = label;
+	}
+	else
+	{
+		head = label;
+	}
+	tail = label;
+	if(address_tails[label->address])
+	{
+		address_tails[label->address]->Next_Address = label;
+	}
+	else
+	{
+		address_heads[label->address] = label;
+	}
+	address_tails[label->address] = label;
+}
+
+/******************************************************************************/
+/** Labels files                                                             **/
+/******************************************************************************/
+
+// Text format (can be edited and imported back)
+void c_label_holder::load_labels_text(void)
 {
     char *line;
-	int real_bank;
-    int bank;
-    int contents;
+	char *buffer;
+	char *end;
+	long size;
     e_dattype type;
     e_dattype sub_type;
-    int jump_table;
-	int offset;
-	int ref_bank;
+	int nbr_records;
+	int max_records;
+	int i;
+	s_label_record *records;
+	s_label_record **sorted;
+	FILE *handle;
 
-    memset(&unknown, 0, sizeof(unknown));
-    unknown.type = TYPE_UNK;
-    unknown.sub_type = TYPE_BYTE;
-    unknown.alias = -2;
 	type = TYPE_DATA;
     sub_type = TYPE_BYTE;
 
-    // Load all the labels
+    // Load the whole file in one go
 	c_tracer reader (nes->Labels_Name, __READ);
-    head = NULL;
+	handle = reader.get_handle();
+	if(!handle)
+	{
+		return;
+	}
+	fseek(handle, 0, SEEK_END);
+	size = ftell(handle);
+	fseek(handle, 0, SEEK_SET);
+	if(size <= 0)
+	{
+		return;
+	}
+	// Padded for the type tags comparisons
+	__NEW_MEM_BLOCK(buffer, char, size + 4);
+	size = (long) fread(buffer, 1, size, handle);
+	memset(&buffer[size], 0, 4);
+	reader.close();
+
+	// One record per line at most
+	max_records = 1;
+	for(i = 0; i < size; i++)
+	{
+		if(buffer[i] == '\n') max_records++;
+	}
+	__NEW_MEM_BLOCK(records, s_label_record, max_records);
+	nbr_records = 0;
 
     // skip header
-    reader.f_read("%s")->string;
-    
-    line = reader.f_read("%s")->string;
+	line = buffer;
+	while(*line && !isspace((unsigned char) *line)) line++;
+
+	for(;;)
+	{
+		while(*line && isspace((unsigned char) *line)) line++;
+		if(!*line)
+		{
+			break;
+		}
+		end = line;
+		while(*end && !isspace((unsigned char) *end)) end++;
+		if(*end)
+		{
+			*end++ = 0;
+		}
 
-    while(strlen(line))
-    {
         // parse the data line
-        offset = strtol(line, &line, 16);
+        records[nbr_records].offset = strtol(line, &line, 16);
         // Skip comma
         line++;
-		real_bank = strtol(line, &line, 16);
+		records[nbr_records].real_bank = strtol(line, &line, 16);
         // Skip comma
         line++;
-		bank = strtol(line, &line, 16);
+		records[nbr_records].alias = strtol(line, &line, 16);
         // Skip comma
         line++;
-        contents = strtol(line, &line, 16);
+        records[nbr_records].contents = strtol(line, &line, 16);
         // Skip comma
         line++;
         switch(((unsigned int ) *(unsigned int *) &line[0]))
@@ -121,20 +495,275 @@ c_label_holder :: c_label_holder (void)
                 break;
         }
         line += 5;
-        jump_table = strtol(line, &line, 16);
+		records[nbr_records].type = type;
+		records[nbr_records].sub_type = sub_type;
+        records[nbr_records].jump_base_table = strtol(line, &line, 16);
         line += 1;
-        ref_bank = strtol(line, &line, 16);
-                
-        insert_label_bank(real_bank, contents, type, sub_type, 0, jump_table, bank, offset, ref_bank);
+        records[nbr_records].ref_bank = strtol(line, &line, 16);
+		records[nbr_records].duplicate = FALSE;
+		nbr_records++;
+
+		line = end;
+    }
+	__DELETE_MEM_BLOCK(buffer);
+
+	// Flag the lines which are repeated verbatim
+	__NEW_MEM_BLOCK(sorted, s_label_record *, nbr_records + 1);
+	for(i = 0; i < nbr_records; i++)
+	{
+		sorted[i] = &records[i];
+	}
+	qsort(sorted, nbr_records, sizeof(s_label_record *), compare_label_records);
+	for(i = 1; i < nbr_records; i++)
+	{
+		if(same_label_records(sorted[i - 1], sorted[i]))
+		{
+			sorted[i]->duplicate = TRUE;
+		}
+	}
+	__DELETE_MEM_BLOCK(sorted);
 
-        line = reader.f_read("%s")->string;   
-    }    
+	// Build the list and its index in file order
+	for(i = 0; i < nbr_records; i++)
+	{
+		if(!records[i].duplicate)
+		{
+	        insert_label_bank(records[i].real_bank, records[i].contents,
+				              (e_dattype) records[i].type, (e_dattype) records[i].sub_type,
+					          0, records[i].jump_base_table, records[i].alias, records[i].offset, records[i].ref_bank);
+		}
+	}
+	__DELETE_MEM_BLOCK(records);
 }
 
-// Dump all labels before closing
-c_label_holder :: ~c_label_holder (void)
+void c_label_holder::save_labels_text(void)
+{
+	s_label_node *navigator;
+
+	c_tracer writer (nes->Labels_Name);
+	writer.f_write ("s", "Offset,Real,Bank,Address,Type,Access,Jump,RefBank\r\n");
+
+	navigator = head;
+
+	while(navigator != NULL)
+	{
+		writer.f_write ("lsnsnsnsssnsns",
+						navigator->offset,
+						",",
+						navigator->real_bank,
+						",",
+						navigator->alias,
+						",",
+						navigator->contents,
+						navigator->type == TYPE_CODE ? ",CODE" : ",DATA",
+						navigator->type == TYPE_CODE ? 
+							navigator->sub_type == TYPE_RELCODE ? ",RELC" : ",CODE" :
+								navigator->sub_type == TYPE_BYTE ? ",BYTE" : 
+									navigator->sub_type == TYPE_WORD ? ",WORD" : ",RAWW",
+						",",
+						navigator->jump_base_table,
+						",",
+						navigator->ref_bank,
+						"\n"
+					);
+
+		navigator = navigator->Next;
+	}
+	writer.close ();
+}
+
+// Binary database (mapped in memory when loaded)
+int c_label_holder::load_labels_db(void)
+{
+	HANDLE file;
+	HANDLE mapping;
+	__UINT_8 *view;
+	DWORD size;
+	s_label_db_header *header;
+	s_label_db_record *record;
+	s_label_node *new_label;
+	struct _stat db_stat;
+	struct _stat text_stat;
+	__UINT_32 i;
+
+	if(_stat(nes->Labels_DB_Name, &db_stat))
+	{
+		return FALSE;
+	}
+	// The text file has been modified since: import it instead
+	if(!_stat(nes->Labels_Name, &text_stat) && text_stat.st_mtime > db_stat.st_mtime)
+	{
+		return FALSE;
+	}
+
+	file = CreateFileA(nes->Labels_DB_Name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(file == INVALID_HANDLE_VALUE)
+	{
+		return FALSE;
+	}
+	size = GetFileSize(file, NULL);
+	if(size == INVALID_FILE_SIZE || size < sizeof(s_label_db_header))
+	{
+		CloseHandle(file);
+		return FALSE;
+	}
+	mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(!mapping)
+	{
+		CloseHandle(file);
+		return FALSE;
+	}
+	view = (__UINT_8 *) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if(!view)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return FALSE;
+	}
+
+	header = (s_label_db_header *) view;
+	if(memcmp(header->magic, LABELS_DB_MAGIC, 4) ||
+	   header->version != LABELS_DB_VERSION ||
+	   header->record_size != sizeof(s_label_db_record) ||
+	   header->nbr_records > ((size - sizeof(s_label_db_header)) / sizeof(s_label_db_record)))
+	{
+		UnmapViewOfFile(view);
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return FALSE;
+	}
+
+	// The records are a straight dump of the list
+	record = (s_label_db_record *) (view + sizeof(s_label_db_header));
+	for(i = 0; i < header->nbr_records; i++, record++)
+	{
+		new_label = alloc_label();
+		new_label->address = record->contents;
+		new_label->contents = record->contents;
+		new_label->bank = (__UINT_8) record->real_bank;
+		new_label->alias = record->alias;
+		new_label->bank_lo = record->alias;
+		new_label->bank_hi = record->alias;
+		new_label->real_bank = record->real_bank;
+		new_label->offset = record->offset;
+		new_label->rom_offset = record->offset;
+		new_label->type = record->type;
+		new_label->sub_type = record->sub_type;
+		new_label->jump_base_table = record->jump_base_table;
+		new_label->ref_bank = record->ref_bank;
+		new_label->Next = NULL;
+		new_label->Next_Address = NULL;
+		link_label(new_label);
+	}
+
+	UnmapViewOfFile(view);
+	CloseHandle(mapping);
+	CloseHandle(file);
+	return TRUE;
+}
+
+void c_label_holder::save_labels_db(void)
+{
+	s_label_db_header header;
+	s_label_db_record *records;
+	s_label_node *navigator;
+	__UINT_32 nbr_records;
+	__UINT_32 i;
+	FILE *out;
+
+	nbr_records = 0;
+	for(navigator = head; navigator; navigator = navigator->Next)
+	{
+		nbr_records++;
+	}
+	__NEW_MEM_BLOCK(records, s_label_db_record, nbr_records + 1);
+	memset(records, 0, (nbr_records + 1) * sizeof(s_label_db_record));
+	for(i = 0, navigator = head; navigator; navigator = navigator->Next, i++)
+	{
+		records[i].offset = navigator->offset;
+		records[i].real_bank = navigator->real_bank;
+		records[i].alias = navigator->alias;
+		records[i].contents = navigator->contents;
+		records[i].type = navigator->type;
+		records[i].sub_type = navigator->sub_type;
+		records[i].jump_base_table = navigator->jump_base_table;
+		records[i].ref_bank = navigator->ref_bank;
+	}
+
+	memcpy(header.magic, LABELS_DB_MAGIC, 4);
+	header.version = LABELS_DB_VERSION;
+	header.record_size = sizeof(s_label_db_record);
+	header.nbr_records = nbr_records;
+
+	out = fopen(nes->Labels_DB_Name, "wb");
+	if(out)
+	{
+		fwrite(&header, sizeof(header), 1, out);
+		fwrite(records, sizeof(s_label_db_record), nbr_records, out);
+		fclose(out);
+	}
+	__DELETE_MEM_BLOCK(records);
+}
+
+// Pages don't move anymore once the disassembling starts
+// so the linear walks can be replaced by direct lookups
+void c_label_holder::build_page_tables(void)
 {
+	s_label_node *pages;
+	int slot;
+
+	free_page_tables();
+	memset(bank_pages, 0, sizeof(bank_pages));
+	memset(address_pages, 0, sizeof(address_pages));
+	max_page_alias = 0;
+	for(pages = nes->prg_pages; pages; pages = pages->Next)
+	{
+		if(pages->alias > max_page_alias)
+		{
+			max_page_alias = pages->alias;
+		}
+	}
+	__NEW_MEM_BLOCK(alias_pages, s_label_node *, max_page_alias + 1);
+	__NEW_MEM_BLOCK(alias_slots, __UINT_8, (max_page_alias + 1) * 16);
+	memset(alias_pages, 0, (max_page_alias + 1) * sizeof(s_label_node *));
+	memset(alias_slots, 0, (max_page_alias + 1) * 16);
+
+	// Keep the first matching page to behave like the walks
+	for(pages = nes->prg_pages; pages; pages = pages->Next)
+	{
+		if(pages->alias >= 0)
+		{
+			if(!alias_pages[pages->alias])
+			{
+				alias_pages[pages->alias] = pages;
+			}
+		}
+		for(slot = pages->address >> 12; slot < ((pages->address + pages->size) >> 12) && slot < 16; slot++)
+		{
+			if(!bank_pages[(pages->bank * 16) + slot])
+			{
+				bank_pages[(pages->bank * 16) + slot] = pages;
+			}
+			if(!address_pages[slot])
+			{
+				address_pages[slot] = pages;
+			}
+			if(pages->alias >= 0)
+			{
+				alias_slots[(pages->alias * 16) + slot] = TRUE;
+			}
+		}
+	}
+	page_tables = TRUE;
+}
 
+void c_label_holder::free_page_tables(void)
+{
+	page_tables = FALSE;
+	__DELETE_MEM_BLOCK(alias_pages);
+	alias_pages = NULL;
+	__DELETE_MEM_BLOCK(alias_slots);
+	alias_slots = NULL;
 }
 
 s_label_node *c_label_holder::search_label(int bank_lo, int bank_hi, int address, int page_alias, int real_ref, int all_refs)
@@ -144,32 +773,35 @@ s_label_node *c_label_holder::search_label(int bank_lo, int bank_hi, int address
 	{
 		real_ref = page_alias;
 	}
-	if(all_refs == -1)
+	if(address >= 0 && address <= 0xffff)
 	{
-		for(navigator = head; navigator;)
+		if(all_refs == -1)
 		{
-			if(navigator->bank_lo >= bank_lo && navigator->bank_hi <= bank_hi &&
-			   navigator->contents == address && get_bank_alias(navigator->ref_bank, address) == real_ref
-			  )
+			for(navigator = address_heads[address]; navigator;)
 			{
-				return(navigator);
+				if(navigator->bank_lo >= bank_lo && navigator->bank_hi <= bank_hi &&
+				   get_bank_alias(navigator->ref_bank, address) == real_ref
+				  )
+				{
+					return(navigator);
+				}
+				navigator = navigator->Next_Address;
 			}
-			navigator = navigator->Next;
 		}
-	}
-	else
-	{
-		for(navigator = head; navigator;)
+		else
 		{
-			if(navigator->bank_lo >= bank_lo && navigator->bank_hi <= bank_hi &&
-			   navigator->contents == address
-			  )
+			for(navigator = address_heads[address]; navigator;)
 			{
-				return(navigator);
+				if(navigator->bank_lo >= bank_lo && navigator->bank_hi <= bank_hi)
+				{
+					return(navigator);
+				}
+				navigator = navigator->Next_Address;
 			}
-			navigator = navigator->Next;
 		}
 	}
+    unknown.type = TYPE_UNK;
+    unknown.sub_type = TYPE_BYTE;
 	unknown.bank = bank_lo;
     unknown.alias = page_alias;
     return(&unknown);
@@ -180,6 +812,10 @@ s_label_node *c_label_holder::search_page(int address)
 {
 	s_label_node *pages;
 
+	if(page_tables && address >= 0 && address <= 0xffff)
+	{
+		return(address_pages[address >> 12]);
+	}
 	for(pages = nes->prg_pages; pages;)
 	{
 		if((address >= pages->address) && (address < (pages->address + pages->size)))
@@ -193,15 +829,9 @@ s_label_node *c_label_holder::search_page(int address)
 
 int c_label_holder::search_unknown_value(int address)
 {
-	s_label_node *navigator;
-
-	for(navigator = head; navigator;)
+	if(address >= 0 && address <= 0xffff && address_heads[address])
 	{
-		if(navigator->address == address)
-		{
-            return(navigator->alias);
-        }
-        navigator = navigator->Next;
+		return(address_heads[address]->alias);
 	}
     return(-1);
 }
@@ -272,6 +902,14 @@ s_label_node *c_label_holder::get_page_from_bank(int bank)
 {
 	s_label_node *pages;
 
+	if(page_tables)
+	{
+		if(bank < 0 || bank > max_page_alias)
+		{
+			return NULL;
+		}
+		return alias_pages[bank];
+	}
 	for(pages = nes->prg_pages; pages;)
 	{
 		if(pages->alias == bank)
@@ -287,6 +925,15 @@ int c_label_holder::get_bank_alias(int bank, int value)
 {
 	s_label_node *pages;
 
+	if(page_tables)
+	{
+		if(bank < 0 || bank > 255 || value < 0 || value > 0xffff)
+		{
+			return 0;
+		}
+		pages = bank_pages[(bank * 16) + (value >> 12)];
+		return pages ? pages->alias : 0;
+	}
 	for(pages = nes->prg_pages; pages;)
 	{
 		if((pages->bank == bank) &&
@@ -304,6 +951,14 @@ int c_label_holder::get_real_bank(int alias)
 {
 	s_label_node *pages;
 
+	if(page_tables)
+	{
+		if(alias < 0 || alias > max_page_alias || !alias_pages[alias])
+		{
+			return 0;
+		}
+		return alias_pages[alias]->bank;
+	}
 	for(pages = nes->prg_pages; pages;)
 	{
 		if(pages->alias == alias)
@@ -319,7 +974,15 @@ int c_label_holder::is_current_page(int bank, int address)
 {
 	s_label_node *pages;
 
-	for(pages = nes->prg_pages; pages;)
+	if(page_tables)
+	{
+		if(bank < 0 || bank > max_page_alias || address < 0 || address > 0xffff)
+		{
+			return FALSE;
+		}
+		return alias_slots[(bank * 16) + (address >> 12)];
+	}
+	for(pages = nes->prg_pages; pages;)
 	{
 		if((address >= pages->address) && (address < (pages->address + pages->size)))
 		{
@@ -330,18 +993,14 @@ int c_label_holder::is_current_page(int bank, int address)
     return FALSE;
 }
 
-void c_label_holder::dump_rom(void)
+// Disassembles a complete prg bank into the listing of the job
+int c_label_holder::generate_prg_bank(s_bank_job *job)
 {
-    int i;
-	int j;
     int k;
-    char inc_name[1024];
-    char bank_name[1024];
     char instruction[1024];
 	char line[1024];
 	char dat_line[1024];
 	SRominformation *infos;
-    FILE *out;
     int instruction_size;
     int pos_export;
     int rom_offset;
@@ -350,513 +1009,776 @@ void c_label_holder::dump_rom(void)
 	int pos_data;
     int sub_t;
     int double_label;
-    int nbr_prg_pages;
-    int nbr_chr_pages;
     int w_dat;
     int in_raw_word;
-    int no_labels;
-    int old_k;
-    int old_offset;
 	int repass;
-	int done_vectors;
 	s_label_node *label;
 	s_label_node *navigator;
-	s_label_node *pages;
-    
-	if (!head)
+	s_label_node *pages = job->pages;
+
+    infos = &nes->o_rom->information();
+	labels_blocked = FALSE;
+	double_label = 0;
+    rom_offset_glob = pages->rom_offset;
+    rom_offset = rom_offset_glob;
+
+	sprintf(line, "; Game name: %s\n", nes->Game_Name);
+    job->listing.Add(line);
+    sprintf(line, "; 16k prg-rom: %d\n", infos->prg_pages);
+    job->listing.Add(line);
+    sprintf(line, "; 8k chr-rom: %d\n", infos->chr_pages);
+    job->listing.Add(line);
+    sprintf(line, "; Mapper: %d\n", infos->mapper);
+    job->listing.Add(line);
+    sprintf(line, "; Mirroring: %d\n", infos->mirroring);
+    job->listing.Add(line);
+    sprintf(line, "; ------------------------------\n");
+    job->listing.Add(line);
+	sprintf(line, "; Disassembled with " APPNAME " " APPVERSION "\n");
+    job->listing.Add(line);
+    sprintf(line, "; ------------------------------\n\n");
+    job->listing.Add(line);
+    sprintf(line, "        .autoimport +\n\n");
+    job->listing.Add(line);
+    sprintf(line, "        .include \"%s_prg.inc\"\n\n", nes->Game_Name);
+    job->listing.Add(line);
+
+	// Dump the exports of this bank
+
+    // Write them 8 by 8
+    navigator = head;
+    pos_export = 0;
+	warnings = 0;
+	for(navigator = head; navigator;)
 	{
-	    return;
+		if(navigator->ref_bank <= pages->bank)
+		{
+			if(navigator->alias == pages->alias &&
+				navigator->sub_type != TYPE_RELCODE &&
+				navigator->sub_type != TYPE_DEAD)
+			{
+				if(navigator->sub_type == TYPE_WORD &&
+				   navigator->jump_base_table != navigator->contents)
+				{
+					goto No_Label;
+				}
+				if(navigator->sub_type == TYPE_RAWWORD &&
+				   navigator->jump_base_table != navigator->contents)
+				{
+					goto No_Label;
+				}
+				if((int) navigator->contents >= pages->address &&
+				   (int) navigator->contents < (pages->address + pages->size))
+				{
+					if((int) navigator->contents > 0x7fff &&
+					   (int) navigator->contents <= 0xfffe)
+					{
+						if((pos_export % 8) == 0)
+						{
+							sprintf(line, "        .export ");
+							job->listing.Add(line);
+						}
+						else
+						{
+							sprintf(line, ", ");
+							job->listing.Add(line);
+						}
+						sprintf(line, "Lbl_%.02x%.04x", navigator->alias, navigator->contents);
+						job->listing.Add(line);
+						if((pos_export % 8) == 7)
+						{
+							sprintf(line, "\n");
+							job->listing.Add(line);
+							pos_export = -1;
+						}
+						pos_export++;
+					}
+				}
+No_Label:;
+			}
+		}
+		navigator = navigator->Next;
+	}
+	if((pos_export % 8) != 0)
+	{
+        sprintf(line, "\n");
+		job->listing.Add(line);
 	}
-	
-    infos = &nes->o_rom->information();
 
-    pages = nes->prg_pages;
-    nbr_prg_pages = 0;
-	rom_offset_glob = 0;
-    if(pages)
-    {
-        rom_offset_glob = pages->rom_offset;
-        while(pages)
-        {
-            nbr_prg_pages++;
-            pages = pages->Next;
-        }
-    }
+    sprintf(line, "\n        .segment \"PRG_%d\"\n", job->bank);
+    job->listing.Add(line);
 
-    nbr_chr_pages = 0;
-    pages = nes->chr_pages;
-    if(pages)
+	rom_offset = rom_offset_glob;
+    // Pass 2: Disassemble the complete bank
+    k = pages->address;
+    repass = -1;
+	while(k < pages->address + pages->size)
     {
-        while(pages)
+        label = search_label(pages->bank_lo, pages->bank_hi, k, pages->alias, -1, 1);
+        label_type = label->type;
+        sub_t = label->sub_type;
+        pos_data = 0;
+
+		if(label_type == TYPE_DATA &&
+           sub_t == TYPE_WORD ||
+           sub_t == TYPE_RAWWORD)
         {
-            nbr_chr_pages++;
-            pages = pages->Next;
-        }
-    }
-
-    pages = nes->prg_pages;
-
-    if(pages)
-    {
-		printf("Disassembling... ");
-
-		nes->o_mapper->reset();
-
-        // Pass 1: fix unresolved code labels
-        for(i = 0; i < (int) nbr_prg_pages; i++)
+			if(repass < k)
+			{
+				if(label->jump_base_table == k)
+				{
+					if(k == nes->o_mapper->vectors_address)
+					{
+						if(!job->vectors)
+						{
+							sprintf(line, "\n        .segment \"VECTORS\"\n\n");
+							job->vectors = TRUE;
+						}
+						job->listing.Add(line);
+						sprintf(line, "Lbl_%.02x%.04x:\n", label->alias, k);
+						job->listing.Add(line);
+					}
+					else
+					{
+						sprintf(line, "\nLbl_%.02x%.04x:\n", label->alias, k);
+						job->listing.Add(line);
+						sprintf(line, "Lbl_%.02x%.04x = Lbl_%.02x%.04x+1\n",
+									label->alias,
+									k + 1,
+									label->alias,
+									k);
+						job->listing.Add(line);
+					}
+				}
+			}
+		}
+        else
+        {
+			if(label_type != TYPE_UNK)
+			{
+				if(!double_label)
+				{
+					if(repass < k)
+					{
+						sprintf(line, "\nLbl_%.02x%.04x:\n",
+									label->alias,
+									k);
+						job->listing.Add(line);
+					}
+				}
+				double_label = 0;
+			}
+		}
+            
+        switch(label_type)
         {
-            rom_offset = rom_offset_glob;
+            case TYPE_CODE:
+                label_type = TYPE_UNK;
+                while(label_type == TYPE_UNK && k < pages->address + pages->size)
+                {
+                    instruction_size = _2A03_get_instruction(pages->address,
+                                                             k,
+                                                             pages->bank_lo,
+                                                             pages->bank_hi,
+                                                             rom_offset,
+                                                             instruction,
+                                                             pages->alias,
+															 label->bank,
+															 label->ref_bank,
+															 pages->bank);
+                    if(labels_blocked)
+                    {
+                        // It needs a new label
+                        return FALSE;
+                    }
+                    if(instruction_size == -2)
+                    {
+						instruction_size = 1;
+                        label_type = TYPE_DATA;
+						goto Direct_Data;
+                        break;
+					}
+                    if(instruction_size == 0xfffffff)
+                    {
+                        // restart
+						repass = k;
+                        k = pages->address;
+                        rom_offset = rom_offset_glob;
+                        break;
+                    }
+					if(k >= repass)
+					{
+						repass = -1;
+					}
+                    if(instruction_size == 0)
+                    {
+                        sprintf(line, "\n; <<< WARNING: Unreachable code !n");
+						job->listing.Add(line);
+                        double_label = 1;
+                        break;
+                    }
+					if(repass < k)
+					{
+						sprintf(line, instruction);
+						job->listing.Add(line);
+					}
+                    k += instruction_size;
+                    switch(nes->o_cpu->PRGROM[rom_offset])
+                    {
+                        // BRK
+                        case 0x0:
+//                              // JSR abs
+//                                case 0x20:
+                        // JMP abs
+                        case 0x4c:
+                        // JMP ind
+                        case 0x6c:
+                        // RTI
+                        case 0x40:
+                        // RTS
+                        case 0x60:
+                            rom_offset += instruction_size;
+							label_type = TYPE_DATA;
+							break;
+
+                        default:
+                            rom_offset += instruction_size;
+							label = search_label(pages->bank_lo, pages->bank_hi, k, pages->alias, -1, 1);
+							label_type = label->type;
+							sub_t = label->sub_type;
+                            break;
+                    }
+					if(label_type != TYPE_UNK)
+					{
+						break;
+					}
+                }
+                break;
 
-            k = pages->address;
-            while(k < pages->address + pages->size)
-            {
-                label = search_label(pages->bank_lo, pages->bank_hi, k, pages->alias, -1, 1);
-                label_type = label->type;
-                sub_t = label->sub_type;
-				
-                switch(label_type)
+            case TYPE_DATA:       // Data
+            case TYPE_UNK:        // Unknown
+Direct_Data:
+                // Determine the size of the array of bytes to dump
+                label_type = TYPE_UNK;
+                in_raw_word = 0;
+				strcpy(line, "");
+				strcpy(dat_line, "");
+                while(label_type == TYPE_UNK && k < pages->address + pages->size)
                 {
-                    case TYPE_CODE:
-                        label_type = TYPE_UNK;
-                        while(label_type == TYPE_UNK &&
-                              k < pages->address + pages->size)
-                        {
-							instruction_size = _2A03_map_instruction(pages->address,
-                                                                     k,
-                                                                     i,
-                                                                     rom_offset,
-                                                                     pages->alias,
-																	 label->alias,
-																	 sub_t);
-                            if(instruction_size == -2)
-                            {
-								label = search_label(pages->bank_lo, pages->bank_hi, k, pages->alias, -1, 1);
-								if(label->type == TYPE_CODE)
+                    switch(sub_t)
+                    {
+                        case TYPE_WORD:
+							if((pos_data % 16) == 0)
+							{
+								if(repass < k)
 								{
-									label->type = TYPE_DATA;
-									label->sub_type = TYPE_DEAD;
+									sprintf(dat_line, "        .word ");
+									strcat(line, dat_line);
+								}
+                            }
+                            w_dat = nes->o_cpu->PRGROM[rom_offset];
+                            w_dat |= nes->o_cpu->PRGROM[rom_offset + 1] << 8;
+							if(w_dat > 0x7fff)
+							{
+								if(repass < k)
+								{
+									sprintf(dat_line, "Lbl_%.02x%.04x", pages->alias, w_dat);
+									strcat(line, dat_line);
 								}
-								instruction_size = 1;
-                                label_type = TYPE_DATA;
-                                break;
 							}
-                            if(instruction_size == -1)
-                            {
-                                // restart
-                                k = pages->address;
-                                rom_offset = rom_offset_glob;
-                                break;
+							else
+							{
+								if(repass < k)
+								{
+									sprintf(dat_line, "$%.04x", w_dat);
+									strcat(line, dat_line);
+								}
+							}
+							// Re-init the line
+							pos_data = 15;
+							break;
+
+                        case TYPE_RAWWORD:
+							if((pos_data % 16) == 0)
+							{
+								if(repass < k)
+								{
+									sprintf(dat_line, "        .word ");
+									strcat(line, dat_line);
+								}
                             }
-                            k += instruction_size;
-                            switch(nes->o_cpu->PRGROM[rom_offset])
+                            else
                             {
-                                // BRK
-                                case 0x0:
-//                                // JSR abs
-  //                              case 0x20:
-                                // JMP abs
-                                case 0x4c:
-                                // JMP ind
-                                case 0x6c:
-                                // RTI
-                                case 0x40:
-                                // RTS
-                                case 0x60:
-                                    rom_offset += instruction_size;
-                                    label_type = TYPE_DATA;
-                                    break;
-
-                                default:
-                                    rom_offset += instruction_size;
-									label = search_label(pages->bank_lo, pages->bank_hi, k, pages->alias, -1, 1);
-									label_type = label->type;
-									sub_t = label->sub_type;
-                                    break;
+                                if(!in_raw_word)
+                                {
+									if(repass < k)
+									{
+										sprintf(dat_line, "\n");
+										strcat(line, dat_line);
+										sprintf(dat_line, "        .word ");
+										strcat(line, dat_line);
+									}
+                                }
                             }
-							if(label_type != TYPE_UNK)
+                            w_dat = nes->o_cpu->PRGROM[rom_offset];
+                            w_dat |= nes->o_cpu->PRGROM[rom_offset + 1] << 8;
+Set_Jump_Table_Start:
+							if(w_dat > 0x7fff)
 							{
-								break;
+								if(repass < k)
+								{
+									sprintf(dat_line, "Lbl_%.02x%.04x", pages->alias, w_dat);
+									strcat(line, dat_line);
+								}
 							}
-                        }
-                        break;
+							else
+							{
+								if(repass < k)
+								{
+									sprintf(dat_line, "$%.04x", w_dat);
+									strcat(line, dat_line);
+								}
+							}
+							in_raw_word = 1;
+							pos_data = 15;
+							break;
 
-                    case TYPE_DATA:       // Data
-                    case TYPE_UNK:        // Unknown
+                        default:
+                            if((pos_data % 16) == 0)
+							{
+								if(repass < k)
+								{
+                                    if(search_base(label->alias, label->address))
+                                    {
+                                        // It's a jump table start
+										sprintf(dat_line, "Lbl_%.02x%.04x = Lbl_%.02x%.04x+1\n",
+													label->alias,
+													k + 1,
+													label->alias,
+													k);
+										strcat(line, dat_line);
 
-                        // Check if all the entries are located in the code
-                        // Determine the size of the array of bytes to dump
-                        label_type = TYPE_UNK;
-                        in_raw_word = 0;
-                        no_labels = 0;
-                        old_offset = rom_offset;
-                        old_k = k;
-                        while(label_type == TYPE_UNK && k < pages->address + pages->size)
-                        {
-                            switch(sub_t)
+                                        sprintf(dat_line, "        .word ");
+										strcat(line, dat_line);
+                                        w_dat = nes->o_cpu->PRGROM[rom_offset];
+                                        w_dat |= nes->o_cpu->PRGROM[rom_offset + 1] << 8;
+                                        // Skip it for next reading
+                                        k++;
+                                        rom_offset++;
+                                        goto Set_Jump_Table_Start;
+                                    }
+                                    else
+                                    {
+										sprintf(dat_line, "        .byte ");
+										strcat(line, dat_line);
+                                    }
+								}
+                            }
+                            else
                             {
-                                case TYPE_WORD:
-                                    w_dat = nes->o_cpu->PRGROM[rom_offset];
-                                    w_dat |= nes->o_cpu->PRGROM[rom_offset + 1] << 8;
-		                            if((int) w_dat <= 0x7fff)
-		                            {
-		                                no_labels++;
-		                            }
-	                                break;
-
-                                case TYPE_RAWWORD:
-                                    w_dat = nes->o_cpu->PRGROM[rom_offset];
-                                    w_dat |= nes->o_cpu->PRGROM[rom_offset + 1] << 8;
-		                            if((int) w_dat <= 0x7fff)
-		                            {
-		                                no_labels++;
-		                            }
-		                            else
-		                            {
-                                        nes->BankJMPList->insert_label_bank(i,
-                                                          w_dat,
-                                                          TYPE_DATA,
-                                                          TYPE_BYTE, 0, 0, pages->alias, rom_offset);
-		                            }
-		                            in_raw_word = 1;
-	                                break;
-
-                                default:
-		                            no_labels++;
-		                            in_raw_word = 0;
-		                            break;
-	                        }
-    	                    
-                            if(sub_t == TYPE_WORD ||
-                               sub_t == TYPE_RAWWORD)
-                            {
-                                k += 2;
-                                rom_offset += 2;
-                            }
-                            else
-                            {
-                                k++;
-                                rom_offset++;
-                            }
-                            label = search_label(pages->bank_lo, pages->bank_hi, k, pages->alias, -1, 1);
-                            label_type = label->type;
-                            sub_t = label->sub_type;
-	                        if(in_raw_word && label_type == TYPE_UNK)
-	                        {
-	                            sub_t = TYPE_RAWWORD;
-	                        }
-	                        if(no_labels)
-                            {
-                                break;
-                            }
-                        }
-                        rom_offset = old_offset;
-                        k = old_k;
-
-                        // Determine the size of the array of bytes to dump
-                        label_type = TYPE_UNK;
-                        while(label_type == TYPE_UNK && k < pages->address + pages->size)
-                        {
-                            if(sub_t == TYPE_WORD || sub_t == TYPE_RAWWORD)
-                            {
-                                k += 2;
-                                rom_offset += 2;
-                            }
-                            else
-                            {
-                                k++;
-                                rom_offset++;
+                                if(in_raw_word)
+                                {
+									if(repass < k)
+									{
+										sprintf(dat_line, "\n");
+										strcat(line, dat_line);
+										sprintf(dat_line, "        .byte ");
+										strcat(line, dat_line);
+									}
+                                }
                             }
-                            label = search_label(pages->bank_lo, pages->bank_hi, k, pages->alias, -1, 1);
-                            label_type = label->type;
-                            sub_t = label->sub_type;
-                        }
-                        break;
+							if(repass < k)
+							{
+								sprintf(dat_line, "$%.02x", nes->o_cpu->PRGROM[rom_offset]);
+								strcat(line, dat_line);
+							}
+							in_raw_word = 0;
+							break;
+					}
+					if((pos_data % 16) == 15)
+					{
+						if(repass < k)
+						{
+							sprintf(dat_line, "\n");
+							strcat(line, dat_line);
+							job->listing.Add(line);
+							strcpy(line, "");
+						}
+					}
+    	                    
+                    if(sub_t == TYPE_WORD || sub_t == TYPE_RAWWORD)
+                    {
+                        k += 2;
+                        rom_offset += 2;
+                    }
+                    else
+                    {
+                        k++;
+                        rom_offset++;
+                    }
+					label = search_label(pages->bank_lo, pages->bank_hi, k, pages->alias, -1, 1);
+                    label_type = label->type;
+                    sub_t = label->sub_type;
+					if((pos_data % 16) != 15)
+					{
+						if(label_type != TYPE_UNK ||
+						   k >= pages->address + pages->size)
+						{
+							if(repass < k)
+							{
+								sprintf(dat_line, "\n");
+								strcat(line, dat_line);
+								job->listing.Add(line);
+								strcpy(line, "");
+							}
+						}
+						else
+						{
+							if(repass < k)
+							{
+								sprintf(dat_line, ",");
+								strcat(line, dat_line);
+							}
+						}
+					}
+					if(in_raw_word && label_type == TYPE_UNK)
+					{
+						sub_t = TYPE_RAWWORD;
+					}
+                    pos_data++;
                 }
-            }
-			pages = pages->Next;
-			if(pages)
-			{
-				rom_offset_glob = pages->rom_offset;
-			}
-         }
+				job->listing.Add(line);
+                break;
+        }
+    }
+	job->warnings = warnings;
+	return TRUE;
+}
 
-		printf("Done.\n");
-		printf("---------------------------------------------------------------------------------\n");
-		printf("Assembly files generation:\n");
+// Dumps a complete chr bank into the listing of the job
+void c_label_holder::generate_chr_bank(s_bank_job *job)
+{
+    int k;
+    int rom_offset;
+	int pos_data;
+	char line[1024];
+	char dat_line[1024];
+	SRominformation *infos;
+	s_label_node *pages = job->pages;
 
-        pages = nes->prg_pages;
-        rom_offset_glob = pages->rom_offset;
-        done_vectors = FALSE;
+    infos = &nes->o_rom->information();
+    rom_offset = pages->rom_offset;
+
+	sprintf(line, "; Game name: %s\n", nes->Game_Name);
+	job->listing.Add(line);
+    sprintf(line, "; prg-rom: %d\n", infos->prg_pages);
+	job->listing.Add(line);
+    sprintf(line, "; chr-rom: %d\n", infos->chr_pages);
+	job->listing.Add(line);
+    sprintf(line, "; Mapper: %d\n", infos->mapper);
+	job->listing.Add(line);
+    sprintf(line, "; Mirroring: %d\n", infos->mirroring);
+	job->listing.Add(line);
+    sprintf(line, "; ------------------------------\n");
+	job->listing.Add(line);
+	sprintf(line, "; Disassembled with " APPNAME " " APPVERSION "\n");
+	job->listing.Add(line);
+    sprintf(line, "; ------------------------------\n\n");
+	job->listing.Add(line);
+    sprintf(line, "        .autoimport +\n\n");
+	job->listing.Add(line);
+    sprintf(line, "\n        .segment \"CHR_%d\"\n\n", pages->bank_lo);
+	job->listing.Add(line);
+
+    // Dump the complete chr bank
+    k = pages->address;
+	pos_data = 0;
+	strcpy(line, "");
+    while(k < pages->address + pages->size)
+    {
+	    if((pos_data % 16) == 0)
+	    {
+            strcat(line, "        .byte ");
+		}
 
-        // Create the constants file
-        sprintf(inc_name, "%s_prg.inc", nes->Game_FileName);
-        out = fopen(inc_name, "wb");
-        if(out)
+		sprintf(dat_line, "$%.02x", nes->o_rom->ROM.read_byte(rom_offset));
+		strcat(line, dat_line);
+
+        k++;
+        rom_offset++;
+
+		if((pos_data % 16) == 15 || k >= pages->address + pages->size)
+	    {
+            strcat(line, "\n");
+			job->listing.Add(line);
+			strcpy(line, "");
+	    }
+        else
         {
-			printf("Generating \"%s\" file... ", inc_name);
+            strcat(line, ",");
+        }
+        pos_data++;
+    }
+}
 
-			fprintf(out, "PPU_CTRL1       =       $2000\n");
-            fprintf(out, "PPU_CTRL2       =       $2001\n");
-            fprintf(out, "PPU_STATUS      =       $2002\n");
+// Takes the jobs one by one until they're all done
+void c_label_holder::run_bank_jobs(void)
+{
+	s_bank_job *job;
+	int index;
 
-            fprintf(out, "PPU_SPRMEM      =       $2003\n");
-            fprintf(out, "PPU_SPRDAT      =       $2004\n");
-            fprintf(out, "PPU_SCROLL      =       $2005\n");
+	labels_locked = TRUE;
+	while((index = InterlockedIncrement(&next_bank_job) - 1) < last_bank_job)
+	{
+		job = &bank_jobs[index];
+		job->listing.Erase();
+		if(job->chr)
+		{
+			generate_chr_bank(job);
+			job->complete = TRUE;
+		}
+		else
+		{
+			job->vectors = job->round_vectors;
+			job->complete = generate_prg_bank(job);
+		}
+	}
+	labels_locked = FALSE;
+}
 
-            fprintf(out, "PPU_MEM         =       $2006\n");
-            fprintf(out, "PPU_MEMDAT      =       $2007\n");
+// Generates the listings of a range of jobs with as many threads
+// as there are processors (the labels are only read meanwhile)
+void c_label_holder::start_bank_jobs(int first, int last, int done_vectors)
+{
+	HANDLE threads[MAX_BANK_THREADS];
+	SYSTEM_INFO system;
+	int nbr_threads;
+	int i;
 
-            fprintf(out, "APU_SQU1_REG1   =       $4000\n");
-            fprintf(out, "APU_SQU1_REG2   =       $4001\n");
-            fprintf(out, "APU_SQU1_REG3   =       $4002\n");
-            fprintf(out, "APU_SQU1_REG4   =       $4003\n");
+	for(i = first; i < last; i++)
+	{
+		bank_jobs[i].complete = FALSE;
+		bank_jobs[i].label_changes = label_changes;
+		bank_jobs[i].round_vectors = done_vectors;
+	}
+	next_bank_job = first;
+	last_bank_job = last;
 
-            fprintf(out, "APU_SQU2_REG1   =       $4004\n");
-            fprintf(out, "APU_SQU2_REG2   =       $4005\n");
-            fprintf(out, "APU_SQU2_REG3   =       $4006\n");
-            fprintf(out, "APU_SQU2_REG4   =       $4007\n");
+	// The current thread takes its share too
+	GetSystemInfo(&system);
+	nbr_threads = (int) system.dwNumberOfProcessors - 1;
+	if(nbr_threads > last - first - 1)
+	{
+		nbr_threads = last - first - 1;
+	}
+	if(nbr_threads > MAX_BANK_THREADS)
+	{
+		nbr_threads = MAX_BANK_THREADS;
+	}
+	for(i = 0; i < nbr_threads; i++)
+	{
+		threads[i] = CreateThread(NULL, 0, bank_jobs_thread, this, 0, NULL);
+	}
+	run_bank_jobs();
+	for(i = 0; i < nbr_threads; i++)
+	{
+		if(threads[i])
+		{
+			WaitForSingleObject(threads[i], INFINITE);
+			CloseHandle(threads[i]);
+		}
+	}
+}
 
-            fprintf(out, "APU_TRI_REG1    =       $4008\n");
-            fprintf(out, "APU_TRI_REG2    =       $4009\n");
-            fprintf(out, "APU_TRI_REG3    =       $400a\n");
-            fprintf(out, "APU_TRI_REG4    =       $400b\n");
+void c_label_holder::dump_rom(void)
+{
+    int i;
+    int k;
+    char inc_name[1024];
+    char bank_name[1024];
+	char line[1024];
+    FILE *out;
+    int instruction_size;
+    int rom_offset;
+    int rom_offset_glob;
+    int label_type;
+    int sub_t;
+    int nbr_prg_pages;
+    int nbr_chr_pages;
+    int w_dat;
+    int in_raw_word;
+    int no_labels;
+    int old_k;
+    int old_offset;
+	int done_vectors;
+	int resume_k;
+	int sync_address;
+	int revisits;
+	int remaps;
+	int nbr_pending;
+	int *pending;
+	__UINT_8 *queued;
+	__UINT_8 *region_starts;
+	s_label_node *label;
+	s_label_node *pages;
+	s_bank_job *job;
+	CList <char *>::CList_Entry *entry;
+    
+	// Get the labels still in the queue
+	flush_labels();
 
-            fprintf(out, "APU_NOISE_REG1  =       $400c\n");
-            fprintf(out, "APU_NOISE_REG2  =       $400d\n");
-            fprintf(out, "APU_NOISE_REG3  =       $400e\n");
-            fprintf(out, "APU_NOISE_REG4  =       $400f\n");
+	if (!head)
+	{
+	    return;
+	}
 
-            fprintf(out, "DMC_CTRL        =       $4010\n");
-            fprintf(out, "DMC_LEV         =       $4011\n");
-            fprintf(out, "DMC_ADDR        =       $4012\n");
-            fprintf(out, "DMC_LEN         =       $4013\n");
+    pages = nes->prg_pages;
+    nbr_prg_pages = 0;
+	rom_offset_glob = 0;
+    if(pages)
+    {
+        rom_offset_glob = pages->rom_offset;
+        while(pages)
+        {
+            nbr_prg_pages++;
+            pages = pages->Next;
+        }
+    }
 
-            fprintf(out, "PPU_SPR_DMA     =       $4014\n");
+    nbr_chr_pages = 0;
+    pages = nes->chr_pages;
+    if(pages)
+    {
+        while(pages)
+        {
+            nbr_chr_pages++;
+            pages = pages->Next;
+        }
+    }
 
-            fprintf(out, "APU_CTRL        =       $4015\n");
+    pages = nes->prg_pages;
 
-            fprintf(out, "NES_JOY1        =       $4016\n");
-            fprintf(out, "NES_JOY2        =       $4017\n");
-            fclose(out);
+    if(pages)
+    {
+		printf("Disassembling... ");
 
-			printf("Done.\n");
-		}
+		nes->o_mapper->reset();
+		build_page_tables();
 
+        // Pass 1: fix unresolved code labels
         for(i = 0; i < (int) nbr_prg_pages; i++)
         {
-			double_label = 0;
-            rom_offset = rom_offset_glob;
-            sprintf(bank_name, "%s_%.03d_prg.asm", nes->Game_FileName, i);
-            out = fopen(bank_name, "wb");
-            if(!out)
-            {
-                break;
-            }
-			listing.Erase();
-			printf("Generating \"%s\" bank file... ", bank_name);
+            // Labels changed behind the scan are queued and only the
+            // regions holding them are scanned again
+            __NEW_MEM_BLOCK(pending, int, pages->size);
+            __NEW_MEM_BLOCK(queued, __UINT_8, pages->size);
+            __NEW_MEM_BLOCK(region_starts, __UINT_8, pages->size);
+            memset(queued, 0, pages->size);
+            memset(region_starts, 0, pages->size);
+            nbr_pending = 0;
+            revisits = 0;
+            remaps = 0;
+            resume_k = -1;
+            sync_address = 0;
 
-			sprintf(line, "; Game name: %s\n", nes->Game_Name);
-            listing.Add(line);
-            sprintf(line, "; 16k prg-rom: %d\n", infos->prg_pages);
-            listing.Add(line);
-            sprintf(line, "; 8k chr-rom: %d\n", infos->chr_pages);
-            listing.Add(line);
-            sprintf(line, "; Mapper: %d\n", infos->mapper);
-            listing.Add(line);
-            sprintf(line, "; Mirroring: %d\n", infos->mirroring);
-            listing.Add(line);
-            sprintf(line, "; ------------------------------\n");
-            listing.Add(line);
-			sprintf(line, "; Disassembled with " APPNAME " " APPVERSION "\n");
-            listing.Add(line);
-            sprintf(line, "; ------------------------------\n\n");
-            listing.Add(line);
-            sprintf(line, "        .autoimport +\n\n");
-            listing.Add(line);
-            sprintf(line, "        .include \"%s_prg.inc\"\n\n", nes->Game_Name);
-            listing.Add(line);
-
-			// Dump the exports of this bank
-
-            // Write them 8 by 8
-            navigator = head;
-            pos_export = 0;
-			warnings = 0;
-	        for(navigator = head; navigator;)
-	        {
-		        if(navigator->ref_bank <= pages->bank)
-		        {
-					if(navigator->alias == pages->alias &&
-						navigator->sub_type != TYPE_RELCODE &&
-						navigator->sub_type != TYPE_DEAD)
-					{
-						if(navigator->sub_type == TYPE_WORD &&
-						   navigator->jump_base_table != navigator->contents)
-						{
-							goto No_Label;
-						}
-						if(navigator->sub_type == TYPE_RAWWORD &&
-						   navigator->jump_base_table != navigator->contents)
-						{
-							goto No_Label;
-						}
-						if((int) navigator->contents >= pages->address &&
-						   (int) navigator->contents < (pages->address + pages->size))
-						{
-							if((int) navigator->contents > 0x7fff &&
-							   (int) navigator->contents <= 0xfffe)
-							{
-								if((pos_export % 8) == 0)
-								{
-									sprintf(line, "        .export ");
-									listing.Add(line);
-								}
-								else
-								{
-									sprintf(line, ", ");
-									listing.Add(line);
-								}
-								sprintf(line, "Lbl_%.02x%.04x", navigator->alias, navigator->contents);
-								listing.Add(line);
-								if((pos_export % 8) == 7)
-								{
-									sprintf(line, "\n");
-									listing.Add(line);
-									pos_export = -1;
-								}
-								pos_export++;
-							}
-						}
-No_Label:;
-					}
-				}
-				navigator = navigator->Next;
-	        }
-	        if((pos_export % 8) != 0)
-	        {
-                sprintf(line, "\n");
-				listing.Add(line);
-	        }
-
-            sprintf(line, "\n        .segment \"PRG_%d\"\n", i);
-            listing.Add(line);
-
-			rom_offset = rom_offset_glob;
-            // Pass 2: Disassemble the complete bank
             k = pages->address;
-            repass = -1;
-			while(k < pages->address + pages->size)
+            for(;;)
             {
+                if(resume_k != -1)
+                {
+                    if(k >= resume_k)
+                    {
+                        // Went past the scan: carry on from here
+                        resume_k = -1;
+                    }
+                    else
+                    {
+                        // Back on a region which was scanned after the change
+                        if(k > sync_address && region_starts[k - pages->address])
+                        {
+                            k = resume_k;
+                            resume_k = -1;
+                        }
+                    }
+                }
+                if(resume_k == -1 && nbr_pending)
+                {
+                    sync_address = pending[--nbr_pending];
+                    queued[sync_address - pages->address] = FALSE;
+                    resume_k = k;
+                    // Start of the region holding that label
+                    k = sync_address;
+                    while(k > pages->address && !region_starts[k - pages->address])
+                    {
+                        k--;
+                    }
+                    revisits++;
+                }
+                if(k >= pages->address + pages->size)
+                {
+                    if(resume_k == -1)
+                    {
+                        break;
+                    }
+                    k = resume_k;
+                    resume_k = -1;
+                    continue;
+                }
+                region_starts[k - pages->address] = TRUE;
+                rom_offset = rom_offset_glob + (k - pages->address);
+
                 label = search_label(pages->bank_lo, pages->bank_hi, k, pages->alias, -1, 1);
                 label_type = label->type;
                 sub_t = label->sub_type;
-                pos_data = 0;
-
-				if(label_type == TYPE_DATA &&
-                   sub_t == TYPE_WORD ||
-                   sub_t == TYPE_RAWWORD)
-                {
-					if(repass < k)
-					{
-						if(label->jump_base_table == k)
-						{
-							if(k == nes->o_mapper->vectors_address)
-							{
-								if(!done_vectors)
-								{
-									sprintf(line, "\n        .segment \"VECTORS\"\n\n");
-									done_vectors = TRUE;
-								}
-								listing.Add(line);
-								sprintf(line, "Lbl_%.02x%.04x:\n", label->alias, k);
-								listing.Add(line);
-							}
-							else
-							{
-								sprintf(line, "\nLbl_%.02x%.04x:\n", label->alias, k);
-								listing.Add(line);
-								sprintf(line, "Lbl_%.02x%.04x = Lbl_%.02x%.04x+1\n",
-											label->alias,
-											k + 1,
-											label->alias,
-											k);
-								listing.Add(line);
-							}
-						}
-					}
-				}
-                else
-                {
-					if(label_type != TYPE_UNK)
-					{
-						if(!double_label)
-						{
-							if(repass < k)
-							{
-								sprintf(line, "\nLbl_%.02x%.04x:\n",
-											label->alias,
-											k);
-								listing.Add(line);
-							}
-						}
-						double_label = 0;
-					}
-				}
-            
+				
                 switch(label_type)
                 {
                     case TYPE_CODE:
                         label_type = TYPE_UNK;
-                        while(label_type == TYPE_UNK && k < pages->address + pages->size)
+                        while(label_type == TYPE_UNK &&
+                              k < pages->address + pages->size)
                         {
-                            instruction_size = _2A03_get_instruction(pages->address,
+							instruction_size = _2A03_map_instruction(pages->address,
                                                                      k,
-                                                                     pages->bank_lo,
-                                                                     pages->bank_hi,
+                                                                     i,
                                                                      rom_offset,
-                                                                     instruction,
                                                                      pages->alias,
-																	 label->bank,
-																	 label->ref_bank,
-																	 pages->bank);
+																	 label->alias,
+																	 sub_t);
                             if(instruction_size == -2)
                             {
+								label = search_label(pages->bank_lo, pages->bank_hi, k, pages->alias, -1, 1);
+								if(label->type == TYPE_CODE)
+								{
+									label->type = TYPE_DATA;
+									label->sub_type = TYPE_DEAD;
+								}
 								instruction_size = 1;
                                 label_type = TYPE_DATA;
-								goto Direct_Data;
                                 break;
 							}
-                            if(instruction_size == 0xfffffff)
-                            {
-                                // restart
-								repass = k;
-                                k = pages->address;
-                                rom_offset = rom_offset_glob;
-                                break;
-                            }
-							if(k >= repass)
-							{
-								repass = -1;
-							}
-                            if(instruction_size == 0)
+                            if(instruction_size == -1)
                             {
-                                sprintf(line, "\n; <<< WARNING: Unreachable code !n");
-								listing.Add(line);
-                                double_label = 1;
-                                break;
+                                // A label changed: map the instruction again
+                                // and revisit the label if it's behind the scan
+                                remaps++;
+                                if(changed_alias == pages->alias &&
+                                   changed_address >= pages->address &&
+                                   changed_address < (resume_k > k ? resume_k : k) &&
+                                   !queued[changed_address - pages->address])
+                                {
+                                    queued[changed_address - pages->address] = TRUE;
+                                    pending[nbr_pending++] = changed_address;
+                                }
+                                continue;
                             }
-							if(repass < k)
-							{
-								sprintf(line, instruction);
-								listing.Add(line);
-							}
                             k += instruction_size;
                             switch(nes->o_cpu->PRGROM[rom_offset])
                             {
                                 // BRK
                                 case 0x0:
-  //                              // JSR abs
-//                                case 0x20:
+//                                // JSR abs
+  //                              case 0x20:
                                 // JMP abs
                                 case 0x4c:
                                 // JMP ind
@@ -866,8 +1788,8 @@ No_Label:;
                                 // RTS
                                 case 0x60:
                                     rom_offset += instruction_size;
-									label_type = TYPE_DATA;
-									break;
+                                    label_type = TYPE_DATA;
+                                    break;
 
                                 default:
                                     rom_offset += instruction_size;
@@ -885,156 +1807,52 @@ No_Label:;
 
                     case TYPE_DATA:       // Data
                     case TYPE_UNK:        // Unknown
-Direct_Data:
+
+                        // Check if all the entries are located in the code
                         // Determine the size of the array of bytes to dump
                         label_type = TYPE_UNK;
                         in_raw_word = 0;
-						strcpy(line, "");
-						strcpy(dat_line, "");
+                        no_labels = 0;
+                        old_offset = rom_offset;
+                        old_k = k;
                         while(label_type == TYPE_UNK && k < pages->address + pages->size)
                         {
                             switch(sub_t)
                             {
                                 case TYPE_WORD:
-	                                if((pos_data % 16) == 0)
-	                                {
-										if(repass < k)
-										{
-											sprintf(dat_line, "        .word ");
-											strcat(line, dat_line);
-										}
-                                    }
                                     w_dat = nes->o_cpu->PRGROM[rom_offset];
                                     w_dat |= nes->o_cpu->PRGROM[rom_offset + 1] << 8;
-		                            if(w_dat > 0x7fff)
+		                            if((int) w_dat <= 0x7fff)
 		                            {
-										if(repass < k)
-										{
-											sprintf(dat_line, "Lbl_%.02x%.04x", pages->alias, w_dat);
-											strcat(line, dat_line);
-										}
-		                            }
-		                            else
-									{
-										if(repass < k)
-										{
-											sprintf(dat_line, "$%.04x", w_dat);
-											strcat(line, dat_line);
-										}
+		                                no_labels++;
 		                            }
-		                            // Re-init the line
-		                            pos_data = 15;
 	                                break;
 
                                 case TYPE_RAWWORD:
-	                                if((pos_data % 16) == 0)
-	                                {
-										if(repass < k)
-										{
-											sprintf(dat_line, "        .word ");
-											strcat(line, dat_line);
-										}
-                                    }
-                                    else
-                                    {
-                                        if(!in_raw_word)
-                                        {
-											if(repass < k)
-											{
-												sprintf(dat_line, "\n");
-												strcat(line, dat_line);
-												sprintf(dat_line, "        .word ");
-												strcat(line, dat_line);
-											}
-                                        }
-                                    }
                                     w_dat = nes->o_cpu->PRGROM[rom_offset];
                                     w_dat |= nes->o_cpu->PRGROM[rom_offset + 1] << 8;
-Set_Jump_Table_Start:
-		                            if(w_dat > 0x7fff)
+		                            if((int) w_dat <= 0x7fff)
 		                            {
-										if(repass < k)
-										{
-											sprintf(dat_line, "Lbl_%.02x%.04x", pages->alias, w_dat);
-											strcat(line, dat_line);
-										}
+		                                no_labels++;
 		                            }
 		                            else
 		                            {
-										if(repass < k)
-										{
-											sprintf(dat_line, "$%.04x", w_dat);
-											strcat(line, dat_line);
-										}
+                                        nes->BankJMPList->insert_label_bank(i,
+                                                          w_dat,
+                                                          TYPE_DATA,
+                                                          TYPE_BYTE, 0, 0, pages->alias, rom_offset);
 		                            }
 		                            in_raw_word = 1;
-		                            pos_data = 15;
 	                                break;
 
                                 default:
-                                    if((pos_data % 16) == 0)
-	                                {
-										if(repass < k)
-										{
-                                            if(search_base(label->alias, label->address))
-                                            {
-                                                // It's a jump table start
-								                sprintf(dat_line, "Lbl_%.02x%.04x = Lbl_%.02x%.04x+1\n",
-											                label->alias,
-											                k + 1,
-											                label->alias,
-											                k);
-											    strcat(line, dat_line);
-
-                                                sprintf(dat_line, "        .word ");
-											    strcat(line, dat_line);
-                                                w_dat = nes->o_cpu->PRGROM[rom_offset];
-                                                w_dat |= nes->o_cpu->PRGROM[rom_offset + 1] << 8;
-                                                // Skip it for next reading
-                                                k++;
-                                                rom_offset++;
-                                                goto Set_Jump_Table_Start;
-                                            }
-                                            else
-                                            {
-											    sprintf(dat_line, "        .byte ");
-											    strcat(line, dat_line);
-                                            }
-										}
-                                    }
-                                    else
-                                    {
-                                        if(in_raw_word)
-                                        {
-											if(repass < k)
-											{
-												sprintf(dat_line, "\n");
-												strcat(line, dat_line);
-												sprintf(dat_line, "        .byte ");
-												strcat(line, dat_line);
-											}
-                                        }
-                                    }
-									if(repass < k)
-									{
-										sprintf(dat_line, "$%.02x", nes->o_cpu->PRGROM[rom_offset]);
-										strcat(line, dat_line);
-									}
+		                            no_labels++;
 		                            in_raw_word = 0;
 		                            break;
 	                        }
-	                        if((pos_data % 16) == 15)
-	                        {
-								if(repass < k)
-								{
-	                                sprintf(dat_line, "\n");
-									strcat(line, dat_line);
-									listing.Add(line);
-									strcpy(line, "");
-								}
-	                        }
     	                    
-                            if(sub_t == TYPE_WORD || sub_t == TYPE_RAWWORD)
+                            if(sub_t == TYPE_WORD ||
+                               sub_t == TYPE_RAWWORD)
                             {
                                 k += 2;
                                 rom_offset += 2;
@@ -1044,73 +1862,189 @@ Set_Jump_Table_Start:
                                 k++;
                                 rom_offset++;
                             }
-							label = search_label(pages->bank_lo, pages->bank_hi, k, pages->alias, -1, 1);
+                            label = search_label(pages->bank_lo, pages->bank_hi, k, pages->alias, -1, 1);
                             label_type = label->type;
                             sub_t = label->sub_type;
-	                        if((pos_data % 16) != 15)
-	                        {
-	                            if(label_type != TYPE_UNK ||
-	                               k >= pages->address + pages->size)
-	                            {
-									if(repass < k)
-									{
-										sprintf(dat_line, "\n");
-										strcat(line, dat_line);
-										listing.Add(line);
-										strcpy(line, "");
-									}
-	                            }
-	                            else
-	                            {
-									if(repass < k)
-									{
-										sprintf(dat_line, ",");
-										strcat(line, dat_line);
-									}
-	                            }
-	                        }
 	                        if(in_raw_word && label_type == TYPE_UNK)
 	                        {
 	                            sub_t = TYPE_RAWWORD;
 	                        }
-                            pos_data++;
+	                        if(no_labels)
+                            {
+                                break;
+                            }
+                        }
+                        rom_offset = old_offset;
+                        k = old_k;
+
+                        // Determine the size of the array of bytes to dump
+                        label_type = TYPE_UNK;
+                        while(label_type == TYPE_UNK && k < pages->address + pages->size)
+                        {
+                            if(sub_t == TYPE_WORD || sub_t == TYPE_RAWWORD)
+                            {
+                                k += 2;
+                                rom_offset += 2;
+                            }
+                            else
+                            {
+                                k++;
+                                rom_offset++;
+                            }
+                            label = search_label(pages->bank_lo, pages->bank_hi, k, pages->alias, -1, 1);
+                            label_type = label->type;
+                            sub_t = label->sub_type;
                         }
-						listing.Add(line);
                         break;
                 }
             }
-			for(j = 0; j < listing.Amount(); j++)
+            __DELETE_MEM_BLOCK(pending);
+            __DELETE_MEM_BLOCK(queued);
+            __DELETE_MEM_BLOCK(region_starts);
+
+            sprintf(line, "Pass 1: bank %d, %d region(s) revisited, %d instruction(s) remapped\r\n", i, revisits, remaps);
+            nes->general_log.f_write("s", line);
+
+			pages = pages->Next;
+			if(pages)
 			{
-				fprintf(out, listing.Get(j)->Content);
+				rom_offset_glob = pages->rom_offset;
 			}
+         }
 
-			fclose(out);
+		printf("Done.\n");
+		printf("---------------------------------------------------------------------------------\n");
+		printf("Assembly files generation:\n");
+
+        pages = nes->prg_pages;
+        done_vectors = FALSE;
+
+        // Create the constants file
+        sprintf(inc_name, "%s_prg.inc", nes->Game_FileName);
+        out = fopen(inc_name, "wb");
+        if(out)
+        {
+			printf("Generating \"%s\" file... ", inc_name);
+
+			fprintf(out, "PPU_CTRL1       =       $2000\n");
+            fprintf(out, "PPU_CTRL2       =       $2001\n");
+            fprintf(out, "PPU_STATUS      =       $2002\n");
+
+            fprintf(out, "PPU_SPRMEM      =       $2003\n");
+            fprintf(out, "PPU_SPRDAT      =       $2004\n");
+            fprintf(out, "PPU_SCROLL      =       $2005\n");
+
+            fprintf(out, "PPU_MEM         =       $2006\n");
+            fprintf(out, "PPU_MEMDAT      =       $2007\n");
+
+            fprintf(out, "APU_SQU1_REG1   =       $4000\n");
+            fprintf(out, "APU_SQU1_REG2   =       $4001\n");
+            fprintf(out, "APU_SQU1_REG3   =       $4002\n");
+            fprintf(out, "APU_SQU1_REG4   =       $4003\n");
+
+            fprintf(out, "APU_SQU2_REG1   =       $4004\n");
+            fprintf(out, "APU_SQU2_REG2   =       $4005\n");
+            fprintf(out, "APU_SQU2_REG3   =       $4006\n");
+            fprintf(out, "APU_SQU2_REG4   =       $4007\n");
+
+            fprintf(out, "APU_TRI_REG1    =       $4008\n");
+            fprintf(out, "APU_TRI_REG2    =       $4009\n");
+            fprintf(out, "APU_TRI_REG3    =       $400a\n");
+            fprintf(out, "APU_TRI_REG4    =       $400b\n");
+
+            fprintf(out, "APU_NOISE_REG1  =       $400c\n");
+            fprintf(out, "APU_NOISE_REG2  =       $400d\n");
+            fprintf(out, "APU_NOISE_REG3  =       $400e\n");
+            fprintf(out, "APU_NOISE_REG4  =       $400f\n");
+
+            fprintf(out, "DMC_CTRL        =       $4010\n");
+            fprintf(out, "DMC_LEV         =       $4011\n");
+            fprintf(out, "DMC_ADDR        =       $4012\n");
+            fprintf(out, "DMC_LEN         =       $4013\n");
+
+            fprintf(out, "PPU_SPR_DMA     =       $4014\n");
+
+            fprintf(out, "APU_CTRL        =       $4015\n");
+
+            fprintf(out, "NES_JOY1        =       $4016\n");
+            fprintf(out, "NES_JOY2        =       $4017\n");
+            fclose(out);
+
+			printf("Done.\n");
+		}
+
+        // Pass 2: Disassemble the banks on several threads
+        // and write them in order
+        __NEW_MEM_BLOCK(bank_jobs, s_bank_job, nbr_prg_pages + nbr_chr_pages);
+        for(i = 0; i < nbr_prg_pages; i++)
+        {
+            bank_jobs[i].pages = pages;
+            bank_jobs[i].bank = i;
+            bank_jobs[i].chr = FALSE;
+            bank_jobs[i].uses_vectors = nes->o_mapper->vectors_address >= pages->address &&
+                                        nes->o_mapper->vectors_address < pages->address + pages->size;
             pages = pages->Next;
-			if(pages)
+        }
+        for(pages = nes->chr_pages; i < nbr_prg_pages + nbr_chr_pages; i++)
+        {
+            bank_jobs[i].pages = pages;
+            bank_jobs[i].bank = i - nbr_prg_pages;
+            bank_jobs[i].chr = TRUE;
+            bank_jobs[i].uses_vectors = FALSE;
+            pages = pages->Next;
+        }
+        start_bank_jobs(0, nbr_prg_pages + nbr_chr_pages, done_vectors);
+
+        for(i = 0; i < (int) nbr_prg_pages; i++)
+        {
+            job = &bank_jobs[i];
+            sprintf(bank_name, "%s_%.03d_prg.asm", nes->Game_FileName, i);
+            out = fopen(bank_name, "wb");
+            if(!out)
+            {
+                break;
+            }
+			printf("Generating \"%s\" bank file... ", bank_name);
+
+            // Do it again here if it needed a new label or if the previous
+            // banks changed the labels (or the vectors) since it was made
+            if(!job->complete || job->label_changes != label_changes ||
+               (job->uses_vectors && job->round_vectors != done_vectors))
+            {
+                job->listing.Erase();
+                job->vectors = done_vectors;
+                generate_prg_bank(job);
+                if(job->label_changes != label_changes && i + 1 < nbr_prg_pages)
+                {
+                    // The next ones are made again with the new labels
+                    start_bank_jobs(i + 1, nbr_prg_pages, job->vectors);
+                }
+            }
+            done_vectors = job->vectors;
+
+			for(entry = job->listing.Get(0); entry; entry = entry->Next)
 			{
-				rom_offset_glob = pages->rom_offset;
+				fprintf(out, entry->Content);
 			}
+            job->listing.Erase();
+
+			fclose(out);
 
 			printf("Done.\n");
-			if(warnings)
+			if(job->warnings)
 			{
 				printf("CAUTION: Source contains one or more warnings !\n");
 			}
         }
     }
 
-    pages = nes->chr_pages;
-
     // dump the chr pages (if any)
-    if(pages)
+    if(bank_jobs)
     {
-        rom_offset_glob = pages->rom_offset;
-        //nes->o_ppu->decode_chr_rom();
         for(i = 0; i < nbr_chr_pages; i++)
         {
-            rom_offset = rom_offset_glob;
-
-			sprintf(bank_name, "%s_%.03d_chr.asm", nes->Game_FileName, pages->bank_lo);
+            job = &bank_jobs[nbr_prg_pages + i];
+			sprintf(bank_name, "%s_%.03d_chr.asm", nes->Game_FileName, job->pages->bank_lo);
             out = fopen(bank_name, "wb");
             if(!out)
             {
@@ -1118,62 +2052,18 @@ Set_Jump_Table_Start:
             }
 			printf("Generating \"%s\" bank file... ", bank_name);
 
-			fprintf(out, "; Game name: %s\n", nes->Game_Name);
-            fprintf(out, "; prg-rom: %d\n", infos->prg_pages);
-            fprintf(out, "; chr-rom: %d\n", infos->chr_pages);
-            fprintf(out, "; Mapper: %d\n", infos->mapper);
-            fprintf(out, "; Mirroring: %d\n", infos->mirroring);
-            fprintf(out, "; ------------------------------\n");
-			fprintf(out, "; Disassembled with " APPNAME " " APPVERSION "\n");
-            fprintf(out, "; ------------------------------\n\n");
-            fprintf(out, "        .autoimport +\n\n");
-            fprintf(out, "\n        .segment \"CHR_%d\"\n\n", pages->bank_lo);
-
-            // Dump the complete chr bank
-            k = pages->address;
-			pos_data = 0;
-
-			// Determine the size of the array of bytes to dump
-            while(k < pages->address + pages->size)
-            {
-	            if((pos_data % 16) == 0)
-	            {
-                    fprintf(out, "        .byte ");
-				}
-
-		        fprintf(out, "$%.02x", nes->o_rom->ROM.read_byte(rom_offset));
-
-				if((pos_data % 16) == 15)
-	            {
-                    fprintf(out, "\n");
-	            }
-    	        
-                k++;
-                rom_offset++;
-
-	            if((pos_data % 16) != 15)
-	            {
-	                if(k >= pages->address + pages->size)
-	                {
-                        fprintf(out, "\n");
-	                }
-	                else
-	                {
-                        fprintf(out, ",");
-	                }
-	            }
-                pos_data++;
-            }
-
-            fclose(out);
-            pages = pages->Next;
-            if(pages)
+			for(entry = job->listing.Get(0); entry; entry = entry->Next)
 			{
-				rom_offset_glob = pages->rom_offset;
+				fprintf(out, entry->Content);
 			}
+            job->listing.Erase();
+
+            fclose(out);
 
 			printf("Done.\n");
 		}
+        __DELETE_MEM_BLOCK(bank_jobs);
+        bank_jobs = NULL;
     }
 
     // Generate the config file
@@ -1352,46 +2242,19 @@ Set_Jump_Table_Start:
 	if (head)
 	{
     
-		c_tracer writer (nes->Labels_Name);
-		writer.f_write ("s", "Offset,Real,Bank,Address,Type,Access,Jump,RefBank\r\n");
-
-		s_label_node *navigator = head;
-
-		while(navigator != NULL)
-		{
-			writer.f_write ("lsnsnsnsssnsns",
-							navigator->offset,
-							",",
-							navigator->real_bank,
-							",",
-							navigator->alias,
-							",",
-							navigator->contents,
-							navigator->type == TYPE_CODE ? ",CODE" : ",DATA",
-							navigator->type == TYPE_CODE ? 
-								navigator->sub_type == TYPE_RELCODE ? ",RELC" : ",CODE" :
-									navigator->sub_type == TYPE_BYTE ? ",BYTE" : 
-										navigator->sub_type == TYPE_WORD ? ",WORD" : ",RAWW",
-							",",
-							navigator->jump_base_table,
-							",",
-							navigator->ref_bank,
-							"\n"
-						);
-
-			navigator = navigator->Next;
-		}
-		// Free the pages mapping
-		while(head)
-		{
-			navigator = head->Next;
-			delete head;
-			head = navigator;
-		}
-		
-		writer.close ();
+		// Text export first so the database is the most recent file
+		save_labels_text();
+		save_labels_db();
+
+		// Free the labels
+		labels.clear();
+		head = NULL;
+		tail = NULL;
+		memset(address_heads, 0, 0x10000 * sizeof(s_label_node *));
+		memset(address_tails, 0, 0x10000 * sizeof(s_label_node *));
 	}
     // Free the pages mapping
+	free_page_tables();
 	for(pages = nes->prg_pages; pages;)
 	{
 		nes->prg_pages = nes->prg_pages->Next;
@@ -1408,37 +2271,59 @@ Set_Jump_Table_Start:
 }
 
 void c_label_holder :: insert_label (__UINT_16 value, e_dattype type, e_dattype sub_type, int force, int base, int ref_bank)
+{
+	s_label_event event;
+
+	event.kind = EVENT_LABEL;
+	event.bank = nes->o_mapper->get_real_prg_bank_number (value);
+	event.value = value;
+	event.type = type;
+	event.sub_type = sub_type;
+	event.force = force;
+	event.base = base;
+	event.ref_bank = (ref_bank == -1) ? event.bank : ref_bank;
+	event.offset = nes->o_cpu->get_rom_offset(value);
+	event.old_bank = -1;
+	post_event(&event);
+}
+
+void c_label_holder :: queue_label_bank (__UINT_8 bank, __UINT_16 value, e_dattype type, e_dattype sub_type,
+										 int force, int base, int ref_bank, int offset, int old_bank)
+{
+	s_label_event event;
+
+	event.kind = EVENT_LABEL_BANK;
+	event.bank = bank;
+	event.value = value;
+	event.type = type;
+	event.sub_type = sub_type;
+	event.force = force;
+	event.base = base;
+	event.ref_bank = ref_bank;
+	event.offset = offset;
+	event.old_bank = old_bank;
+	post_event(&event);
+}
+
+void c_label_holder :: add_label (__UINT_16 value, e_dattype type, e_dattype sub_type, int force, int base, int ref_bank,
+								  int bank, int offset)
 {
     int bank_alias;
     int bank_num;
-	__UINT_8 bank = nes->o_mapper->get_real_prg_bank_number (value);
 
-	if(ref_bank == -1) ref_bank = bank;
-
-	if (!head)
-	{
-        bank_num = bank;
-        bank_alias = nes->BankJMPList->get_bank_alias(bank_num, value);
-		head = nes->o_mapper->create_label (head, value, type, sub_type, base, nes->o_cpu->get_rom_offset(value), ref_bank, 
-                                            bank_num, bank_alias);
-		return;
-	}
-	
-	s_label_node *navigator = head;
-    s_label_node *PrevNode = head;
+	s_label_node *navigator = address_heads[value];
+    s_label_node *new_label;
 
 	__BOOL is_found = FALSE;
 
 	while ((NULL != navigator) && !is_found)
 	{
-		PrevNode = navigator;
-		if ((navigator->address == value) &&
-			(navigator->ref_bank == ref_bank))
+		if (navigator->ref_bank == ref_bank)
 	    {
 	        is_found = TRUE;
 	        break;
         }
-		navigator = navigator->Next;
+		navigator = navigator->Next_Address;
 	}
 	
 	if(is_found)
@@ -1474,8 +2359,12 @@ void c_label_holder :: insert_label (__UINT_16 value, e_dattype type, e_dattype
 	{
         bank_num = bank;
         bank_alias = nes->BankJMPList->get_bank_alias(bank_num, value);
-		PrevNode->Next = nes->o_mapper->create_label (head, value, type, sub_type, base, nes->o_cpu->get_rom_offset(value), ref_bank,
-                                                      bank_num, bank_alias);
+		new_label = nes->o_mapper->create_label (address_heads[value], value, type, sub_type, base, offset, ref_bank,
+                                                 bank_num, bank_alias);
+        if(new_label)
+        {
+            link_label(new_label);
+        }
 	}
 }
 
@@ -1491,34 +2380,19 @@ int c_label_holder :: insert_label_bank (__UINT_8 bank,
 										 int old_bank,
 										 int jmp_pos)
 {
-	if (!head)
-	{
-        head = nes->o_mapper->create_label (head, value, type, sub_type, base, offset,
-                                            old_bank == -1 ? bank : old_bank,
-                                            bank, get_bank_alias(bank, value));
-        if(head == NULL)
-        {
-		    return 0;
-        }
-		return 1;
-	}
-	
-	s_label_node *navigator = head;
-    s_label_node *PrevNode = head;
+	s_label_node *navigator = address_heads[value];
+    s_label_node *new_label;
 
 	__BOOL is_found = FALSE;
 
 	while ((NULL != navigator) && !is_found)
 	{
-		PrevNode = navigator;
-		if ((navigator->contents == value)
-			&& (get_bank_alias(navigator->ref_bank, value) == ref_bank)
-		   )
+		if (get_bank_alias(navigator->ref_bank, value) == ref_bank)
 	    {
 	        is_found = TRUE;
 	        break;
         }
-		navigator = navigator->Next;
+		navigator = navigator->Next_Address;
 	}
 	
 	if(is_found)
@@ -1532,6 +2406,11 @@ int c_label_holder :: insert_label_bank (__UINT_8 bank,
 				{
 					if(navigator->sub_type != TYPE_WORD && navigator->sub_type != TYPE_RAWWORD || type == TYPE_CODE)
 					{
+						if(labels_frozen())
+						{
+							return 0;
+						}
+						label_changes++;
 						navigator->type = type;
 						navigator->sub_type = sub_type;
 						navigator->jump_base_table = base;
@@ -1541,6 +2420,11 @@ int c_label_holder :: insert_label_bank (__UINT_8 bank,
 				{
 					if(type == TYPE_CODE && navigator->type != TYPE_CODE)
 					{
+						if(labels_frozen())
+						{
+							return 0;
+						}
+						label_changes++;
 						// Replace the label if the new one is of CODE type
 						// Since it must be disassembled (code have precedence).
 						navigator->type = TYPE_CODE;
@@ -1550,7 +2434,11 @@ int c_label_holder :: insert_label_bank (__UINT_8 bank,
 						   (old_bank == navigator->real_bank))
 						{
 							if(jmp_pos > value)
+							{
+								changed_address = value;
+								changed_alias = navigator->alias;
 								return -1;
+							}
 						}
 					}
 				}
@@ -1560,13 +2448,22 @@ int c_label_holder :: insert_label_bank (__UINT_8 bank,
 	}
 	else
 	{
-		PrevNode->Next = nes->o_mapper->create_label (head, value, type, sub_type, base, offset,
-                                                      old_bank == -1 ? bank : old_bank,
-                                                      bank, ref_bank);
-        if(PrevNode->Next == NULL)
+		if(labels_frozen())
+		{
+			return 0;
+		}
+		// The very first label is aliased from its own bank
+		new_label = nes->o_mapper->create_label (address_heads[value], value, type, sub_type, base, offset,
+                                                 old_bank == -1 ? bank : old_bank,
+                                                 bank, head ? ref_bank : get_bank_alias(bank, value));
+        if(new_label == NULL)
         {
             return 0;
         }
+        link_label(new_label);
+		label_changes++;
+		changed_address = value;
+		changed_alias = new_label->alias;
         return 1;
 	}
     return 0;
@@ -54,6 +54,10 @@ c_nes :: c_nes()
 {
     prg_pages = NULL;
     chr_pages = NULL;
+    o_cdl = NULL;
+    o_cpu = NULL;
+    log_tracer = FALSE;
+    dynarec = FALSE;
 }
 
 void c_nes :: Open (int PAL, const char *FilePath)
@@ -61,6 +65,8 @@ void c_nes :: Open (int PAL, const char *FilePath)
     MSG msg;
 
     general_log.set_output_file (APPNAME".log", __NEW);
+    general_log.set_async (TRUE);
+    instruction_trace.set_output_file (APPNAME".trace");
 
     __NEW (o_rom, c_nes_rom (FilePath));
     bIsPowerOff = o_rom->check_header (PAL);
@@ -80,8 +86,11 @@ void c_nes :: Open (int PAL, const char *FilePath)
     __NEW (o_control, c_nes_control);
     __NEW (o_input, c_input);
     __NEW (o_cpu, c_nes_cpu);
+    o_cpu->set_logtracer (log_tracer);
     __NEW (o_gfx, c_graphics);
     __NEW (o_ppu, c_nes_ppu);
+    __NEW (o_cdl, c_code_data_log (o_rom->information ().prg_pages * _16K_,
+                                   o_rom->information ().chr_pages * _8K_));
 
     switch (o_rom->information ().mapper)
     {
@@ -172,13 +181,18 @@ void c_nes :: Open (int PAL, const char *FilePath)
     }
 
     strcpy(Labels_Name, FilePath);
+    strcpy(Labels_DB_Name, FilePath);
+    strcpy(CDL_Name, FilePath);
     strcpy(Game_FileName, FilePath);
     strcpy(Game_Name, FilePath);
     o_state->get_filename(Labels_Name, "txt", 0);
+    o_state->get_filename(Labels_DB_Name, "lbl", 0);
+    o_state->get_filename(CDL_Name, "cdl", 0);
     o_state->get_filename(Game_FileName, "", 0);
     o_state->get_filename(Game_Name, "", 1);
 
     __NEW (BankJMPList, c_label_holder);
+    o_cdl->load (CDL_Name);
 
     bis_running = TRUE;
     bis_paused = FALSE;
@@ -214,6 +228,7 @@ void c_nes :: close (void)
         bIsPowerOff = TRUE;
 
         BankJMPList->dump_rom();
+        o_cdl->save (CDL_Name);
 
         if ((nes->o_rom->information ().mapper != 0 &&
             nes->o_rom->information ().mapper != 2) ||
@@ -234,7 +249,9 @@ void c_nes :: close (void)
         __DELETE (o_sram);
         __DELETE (o_state);
         __DELETE (BankJMPList);
+        __DELETE (o_cdl);
         general_log.close ();
+        instruction_trace.close ();
     }
 }
 
@@ -273,9 +290,20 @@ void c_nes :: set_instruction_dumper (__BOOL o_state)
     o_cpu->toggle_tracer ();
 }
 
+// Can be called before the rom is opened
 void c_nes :: set_log_tracer(__BOOL o_state)
 {
-    o_cpu->set_logtracer (o_state);
+    log_tracer = o_state;
+    if (o_cpu)
+    {
+        o_cpu->set_logtracer (o_state);
+    }
+}
+
+// Has to be called before the rom is opened
+void c_nes :: set_dynarec(__BOOL o_state)
+{
+    dynarec = o_state;
 }
 
 void c_nes :: set_label_holder (__BOOL o_state)
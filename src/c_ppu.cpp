@@ -26,6 +26,11 @@
 #include <stdio.h>
 #include <string.h>
 
+#if defined (_M_IX86) || defined (_M_X64) || defined (__SSE2__)
+#include <emmintrin.h>
+#define _2C02_SSE2
+#endif
+
 #include "include/c_nes.h"
 #include "include/c_mem_block.h"
 #include "include/c_control.h"
@@ -43,7 +48,7 @@
 /** External Data                                                            **/
 /******************************************************************************/
 
-extern c_machine *o_machine;
+extern __THREAD_LOCAL c_machine *o_machine;
 
 /******************************************************************************/
 /** Local Data                                                               **/
@@ -59,6 +64,8 @@ __UINT_16 mirroring_modes [][4] =
 
 };
 
+__UINT_32 c_nes_ppu :: tileline_spread [256] [2];
+
 /******************************************************************************/
 /** Installer                                                                **/
 /******************************************************************************/
@@ -101,6 +108,18 @@ c_nes_ppu :: c_nes_ppu (void)
     memset (low_pattern_set, 0x00, sizeof(low_pattern_set));
     memset (high_pattern_set, 0x00, sizeof(high_pattern_set));
 
+    // Pixel 0 is the highest bit and ends in the lowest byte
+    for (__UINT_32 bits = 0; bits < 256; bits ++)
+    {
+        tileline_spread [bits] [0] = 0;
+        tileline_spread [bits] [1] = 0;
+        for (__UINT_32 pixel = 0; pixel < 4; pixel ++)
+        {
+            tileline_spread [bits] [0] |= ((bits >> (7 - pixel)) & 1) << (pixel << 3);
+            tileline_spread [bits] [1] |= ((bits >> (3 - pixel)) & 1) << (pixel << 3);
+        }
+    }
+
     //VRAM -> 16K bytes
     //CHRROM -> Size is determined by the ROM header.
     VRAM.resize (_16K_);
@@ -123,6 +142,7 @@ c_nes_ppu :: c_nes_ppu (void)
 
     oam_inrange_sp = oam_address = 0;
     po_present = FALSE;
+    is_sprite_lines_dirty = TRUE;
 
     //mirroring set-up
     switch (nes->o_rom->information ().mirroring)
@@ -160,6 +180,10 @@ c_nes_ppu :: c_nes_ppu (void)
             pattern_pages_backup [pageIndex] = pageIndex;
         }
     }
+    dirty_pages = 0;
+    ppu_writes = 0;
+    line_ppu_writes = 0;
+    is_fast_line = FALSE;
 
     nes->is_mmc2_vrom = FALSE;
     switch(nes->o_rom->information().mapper)
@@ -192,6 +216,17 @@ c_nes_ppu :: ~c_nes_ppu (void)
 
 void c_nes_ppu :: run_accurate ()
 {
+    // The cpu can't run past the mapper irq in hblank (or the end of the line)
+    // before the PPU rendered it, the MMC5 is always run in lockstep
+    __BOOL is_lazy = (nes->o_rom->information ().mapper != 5) ? TRUE : FALSE;
+    __INT_32 hblank_time = nes->o_cpu->event_time (260);
+    __INT_32 line_end_time = nes->o_cpu->event_time (340);
+
+    if (is_lazy)
+    {
+        nes->o_cpu->run_ahead (hblank_time);
+    }
+
     clear_solid_pixel_lut ();
 
     info.x_offset = 0;
@@ -201,6 +236,15 @@ void c_nes_ppu :: run_accurate ()
     po_present = FALSE;
     oam_inrange_sp = 0;
 
+    if (is_sprite_lines_dirty)
+    {
+        build_sprite_lines ();
+    }
+
+    // The MMC5 fetches are always done pixel by pixel
+    line_ppu_writes = ppu_writes;
+    is_fast_line = (nes->o_rom->information ().mapper != 5) ? TRUE : FALSE;
+
     __BOOL bSpritesRendered = FALSE;
     
     //Sprite Rendering.
@@ -265,6 +309,11 @@ void c_nes_ppu :: run_accurate ()
     //Memory fetch phase #2-128
     for (bTile = 1; bTile < 32; bTile ++, accurate_tile_index ++)
     {
+        // Again once the access it stopped at was done
+        if (is_lazy)
+        {
+            nes->o_cpu->run_ahead (hblank_time);
+        }
         if (nes->is_mmc2_vrom)
         {
             int changeline = info.bg_pattern_base | (nt_set[bTile + 1] << 4);
@@ -305,6 +354,10 @@ void c_nes_ppu :: run_accurate ()
 
     for (__UINT_32 uiIndex = 0; uiIndex < 7; uiIndex ++)
     {
+        if (is_lazy)
+        {
+            nes->o_cpu->run_ahead (line_end_time);
+        }
         nes->o_cpu->run_cycles (8);
         FetchObjectData ();
     }
@@ -395,6 +448,149 @@ void c_nes_ppu :: run_accurate ()
     }
 }
 
+// Pixels of the tiles which weren't already drawn at once,
+// a write landing during the tile redraws the rest of it
+#define _2C02_DRAW_TILE_PIXEL() \
+{ \
+    if (is_fast_tile && ppu_writes != line_ppu_writes) \
+    { \
+        is_fast_tile = FALSE; \
+        unpacked_pixel_index -= 8 - tile_pixel; \
+        destination += tile_pixel; \
+        solid += tile_pixel; \
+        /* Forget a sprite 0 hit found on the pixels to redraw */ \
+        if (!tile_po_flag && info.po_flag && \
+            info.po_collision_cycle >= ((info.scanline * 341) + (unpacked_pixel_index - reg.fh) - ((!is_frame_even) ? 1 : 0)) * \
+                                       (!nes->o_cpu->is_pal () ? 16 : 15)) \
+        { \
+            info.po_flag = FALSE; \
+            info.is_collision_event_pending = tile_collision_pending; \
+        } \
+    } \
+    if (!is_fast_tile) \
+    { \
+        attribute = at_set [(unpacked_pixel_index >> 3)]; \
+        _2C02_DRAW_ACCURATE_PIXEL (__UINT_16, unpacked_pixel_data, final_color, attribute, destination, solid, unpacked_pixel_index); \
+    } \
+    tile_pixel ++; \
+}
+
+void c_nes_ppu :: draw_bg_tile (__UINT_16 *destination, __UINT_8 *solid)
+{
+    __UINT_8 *pixel_data = unpacked_pixel_data + unpacked_pixel_index;
+    __UINT_16 final_color;
+    __UINT_8 attribute;
+
+    // Empty pattern row and no sprite under it
+    if (get_flag (CTL_2, BIT_3) &&
+        !*((__UINT_32 *) pixel_data) && !*((__UINT_32 *) (pixel_data + 4)) &&
+        !*((__UINT_32 *) solid) && !*((__UINT_32 *) (solid + 4)))
+    {
+        register __UINT_32 color = _2C02_NES_COLOR (__UINT_16, background_palette, 0);
+        color |= color << 16;
+        *((__UINT_32 *) destination) = color;
+        *((__UINT_32 *) destination + 1) = color;
+        *((__UINT_32 *) destination + 2) = color;
+        *((__UINT_32 *) destination + 3) = color;
+        unpacked_pixel_index += 8;
+        return;
+    }
+
+#ifdef _2C02_SSE2
+    if (get_flag (CTL_2, BIT_3))
+    {
+        compose_bg_tile (destination, solid);
+        return;
+    }
+#endif
+
+    for (__UINT_8 pixel = 0; pixel < 8; pixel ++)
+    {
+        attribute = at_set [(unpacked_pixel_index >> 3)];
+        _2C02_DRAW_ACCURATE_PIXEL (__UINT_16, unpacked_pixel_data, final_color, attribute, destination, solid, unpacked_pixel_index);
+    }
+}
+
+#ifdef _2C02_SSE2
+
+/******************************************************************************/
+/** compose_bg_tile ()                                                       **/
+/**                                                                          **/
+/** Same result as _2C02_DRAW_ACCURATE_PIXEL with the background enabled,   **/
+/** the priorities against the sprites are solved for the 8 pixels at once. **/
+/******************************************************************************/
+
+void c_nes_ppu :: compose_bg_tile (__UINT_16 *destination, __UINT_8 *solid)
+{
+    __UINT_8 *pixel_data = unpacked_pixel_data + unpacked_pixel_index;
+    __UINT_8 attributes [16];
+    __UINT_8 indexes [16];
+    __UINT_16 colors [8];
+    __UINT_8 pixel;
+    int hits;
+
+    for (pixel = 0; pixel < 8; pixel ++)
+    {
+        attributes [pixel] = at_set [(unpacked_pixel_index + pixel) >> 3];
+    }
+
+    const __m128i zero = _mm_setzero_si128 ();
+    const __m128i bit_2 = _mm_set1_epi8 (BIT_2);
+    const __m128i bit_3 = _mm_set1_epi8 (BIT_3);
+    const __m128i bit_4 = _mm_set1_epi8 (BIT_4);
+    __m128i pixels = _mm_loadl_epi64 ((__m128i *) pixel_data);
+    __m128i solids = zero;
+
+    // The sprites are cleared when they're disabled
+    if (get_flag (CTL_2, BIT_4))
+    {
+        solids = _mm_loadl_epi64 ((__m128i *) solid);
+    }
+    else
+    {
+        _mm_storel_epi64 ((__m128i *) solid, zero);
+    }
+
+    __m128i transparent = _mm_cmpeq_epi8 (pixels, zero);
+    __m128i empty = _mm_cmpeq_epi8 (solids, zero);
+    // Sprite behind the background (or not displayed)
+    __m128i behind = _mm_or_si128 (_mm_cmpeq_epi8 (_mm_and_si128 (solids, bit_2), zero),
+                                   _mm_cmpeq_epi8 (_mm_and_si128 (solids, bit_3), bit_3));
+    __m128i write = _mm_or_si128 (empty, _mm_andnot_si128 (transparent, behind));
+    __m128i hit = _mm_andnot_si128 (_mm_or_si128 (transparent, empty),
+                                    _mm_cmpeq_epi8 (_mm_and_si128 (solids, bit_4), bit_4));
+
+    // Palette entries (the transparent pixels take the backdrop)
+    _mm_storeu_si128 ((__m128i *) indexes,
+                      _mm_andnot_si128 (transparent, _mm_or_si128 (pixels, _mm_loadl_epi64 ((__m128i *) attributes))));
+    for (pixel = 0; pixel < 8; pixel ++)
+    {
+        colors [pixel] = _2C02_NES_COLOR (__UINT_16, background_palette, indexes [pixel]);
+    }
+
+    __m128i mask = _mm_unpacklo_epi8 (write, write);
+    __m128i result = _mm_or_si128 (_mm_and_si128 (mask, _mm_loadu_si128 ((__m128i *) colors)),
+                                   _mm_andnot_si128 (mask, _mm_loadu_si128 ((__m128i *) destination)));
+    _mm_storeu_si128 ((__m128i *) destination, result);
+
+    if (is_primary_backup && !info.po_flag)
+    {
+        hits = _mm_movemask_epi8 (hit) & 0xff;
+        if (hits)
+        {
+            for (pixel = 0; !(hits & (1 << pixel)); pixel ++);
+            info.is_collision_event_pending = TRUE;
+            info.po_flag = TRUE;
+            info.po_collision_cycle = (info.scanline * 341) + ((unpacked_pixel_index + pixel) - reg.fh) - ((!is_frame_even) ? 1 : 0);
+            info.po_collision_cycle *= (!nes->o_cpu->is_pal () ? 16 : 15);
+        }
+    }
+
+    unpacked_pixel_index += 8;
+}
+
+#endif
+
 void c_nes_ppu :: render_bg_tileline16 (void)
 {
     if (!bTile)
@@ -426,19 +622,27 @@ void c_nes_ppu :: render_bg_tileline16 (void)
         EvaluateOAMEntry ();
     }
 
-    _2C02_DRAW_ACCURATE_PIXEL (__UINT_16, unpacked_pixel_data, final_color, attribute, destination, solid, unpacked_pixel_index);
+    // Nothing the line depends on was written since it started,
+    // so the whole tile is drawn at once
+    __BOOL is_fast_tile = (is_fast_line && ppu_writes == line_ppu_writes) ? TRUE : FALSE;
+    __BOOL tile_po_flag = info.po_flag;
+    __BOOL tile_collision_pending = info.is_collision_event_pending;
+    __UINT_8 tile_pixel = 0;
+    if (is_fast_tile)
+    {
+        draw_bg_tile (destination, solid);
+    }
+
+    _2C02_DRAW_TILE_PIXEL ();
     Setnt_address ();
     nes->o_cpu->run_cycles (1);
-    attribute = at_set [(unpacked_pixel_index >> 3)];
-    _2C02_DRAW_ACCURATE_PIXEL (__UINT_16, unpacked_pixel_data, final_color, attribute, destination, solid, unpacked_pixel_index);
+    _2C02_DRAW_TILE_PIXEL ();
     FetchnametableDataAddress ();
     nes->o_cpu->run_cycles (1);
     FetchAttributeData ();
-    attribute = at_set [(unpacked_pixel_index >> 3)];
-    _2C02_DRAW_ACCURATE_PIXEL (__UINT_16, unpacked_pixel_data, final_color, attribute, destination, solid, unpacked_pixel_index);
+    _2C02_DRAW_TILE_PIXEL ();
     nes->o_cpu->run_cycles (1);
-    attribute = at_set [(unpacked_pixel_index >> 3)];
-    _2C02_DRAW_ACCURATE_PIXEL (__UINT_16, unpacked_pixel_data, final_color, attribute, destination, solid, unpacked_pixel_index);
+    _2C02_DRAW_TILE_PIXEL ();
     if (bTile != 31)
     {
         nes->o_cpu->run_cycles (1);
@@ -459,23 +663,19 @@ void c_nes_ppu :: render_bg_tileline16 (void)
     if (bTile != 31)
     {
         //FetchLowPatternData ();
-        attribute = at_set [(unpacked_pixel_index >> 3)];
-        _2C02_DRAW_ACCURATE_PIXEL (__UINT_16, unpacked_pixel_data, final_color, attribute, destination, solid, unpacked_pixel_index);
+        _2C02_DRAW_TILE_PIXEL ();
         SetPatternDataAddress ();
         nes->o_cpu->run_cycles (1);
-        attribute = at_set [(unpacked_pixel_index >> 3)];
-        _2C02_DRAW_ACCURATE_PIXEL (__UINT_16, unpacked_pixel_data, final_color, attribute, destination, solid, unpacked_pixel_index);
+        _2C02_DRAW_TILE_PIXEL ();
         is_mmc5_vrom = ((nes->o_rom->information ().mapper == 5) && 
                          nes->o_ppu->get_flag (CTL_1, BIT_5) && 
                          nes->o_ppu->get_flag (CTL_2, BIT_3 | BIT_4)) ? TRUE : FALSE;
         FetchLowPatternDataAddress ();
         nes->o_cpu->run_cycles (1);
-        attribute = at_set [(unpacked_pixel_index >> 3)];
-        _2C02_DRAW_ACCURATE_PIXEL (__UINT_16, unpacked_pixel_data, final_color, attribute, destination, solid, unpacked_pixel_index);
+        _2C02_DRAW_TILE_PIXEL ();
         SetPatternDataAddress ();
         nes->o_cpu->run_cycles (1);
-        attribute = at_set [(unpacked_pixel_index >> 3)];
-        _2C02_DRAW_ACCURATE_PIXEL (__UINT_16, unpacked_pixel_data, final_color, attribute, destination, solid, unpacked_pixel_index);
+        _2C02_DRAW_TILE_PIXEL ();
         is_mmc5_vrom = ((nes->o_rom->information ().mapper == 5) &&
                          nes->o_ppu->get_flag (CTL_1, BIT_5) &&
                          nes->o_ppu->get_flag (CTL_2, BIT_3 | BIT_4)) ? TRUE : FALSE;
@@ -484,17 +684,13 @@ void c_nes_ppu :: render_bg_tileline16 (void)
     }
     else 
     {
-        attribute = at_set [(unpacked_pixel_index >> 3)];
-        _2C02_DRAW_ACCURATE_PIXEL (__UINT_16, unpacked_pixel_data, final_color, attribute, destination, solid, unpacked_pixel_index);
+        _2C02_DRAW_TILE_PIXEL ();
         nes->o_cpu->run_cycles (1);
-        attribute = at_set [(unpacked_pixel_index >> 3)];
-        _2C02_DRAW_ACCURATE_PIXEL (__UINT_16, unpacked_pixel_data, final_color, attribute, destination, solid, unpacked_pixel_index);
+        _2C02_DRAW_TILE_PIXEL ();
         nes->o_cpu->run_cycles (1);
-        attribute = at_set [(unpacked_pixel_index >> 3)];
-        _2C02_DRAW_ACCURATE_PIXEL (__UINT_16, unpacked_pixel_data, final_color, attribute, destination, solid, unpacked_pixel_index);
+        _2C02_DRAW_TILE_PIXEL ();
         nes->o_cpu->run_cycles (1);
-        attribute = at_set [(unpacked_pixel_index >> 3)];
-        _2C02_DRAW_ACCURATE_PIXEL (__UINT_16, unpacked_pixel_data, final_color, attribute, destination, solid, unpacked_pixel_index);
+        _2C02_DRAW_TILE_PIXEL ();
         nes->o_cpu->run_cycles (1);
     }
 
@@ -688,6 +884,34 @@ void c_nes_ppu :: render_sp_tileline_16 (__UINT_16 x_offset, __UINT_16 tileline,
     }
 }
 
+/******************************************************************************/
+/** build_sprite_lines ()                                                    **/
+/**                                                                          **/
+/** Lists the sprites in range of each line, in OAM order, so the evaluation **/
+/** doesn't have to compare all 64 of them on every line.                    **/
+/******************************************************************************/
+
+void c_nes_ppu :: build_sprite_lines (void)
+{
+    __UINT_32 height = (!get_flag (CTL_1, BIT_5)) ? 8 : 16;
+
+    memset (sprite_lines_count, 0, sizeof (sprite_lines_count));
+    for (__UINT_32 sprite = 0; sprite < 64; sprite ++)
+    {
+        __UINT_32 line = OAM [sprite << 2];
+        __UINT_32 last_line = line + height;
+
+        for (; line < last_line && line < 256; line ++)
+        {
+            if (sprite_lines_count [line] < 9)
+            {
+                sprite_lines [line] [sprite_lines_count [line] ++] = (__UINT_8) sprite;
+            }
+        }
+    }
+    is_sprite_lines_dirty = FALSE;
+}
+
 void c_nes_ppu :: FetchObjectData (void)
 {
     if (!get_flag (CTL_2, BIT_3 | BIT_4) || !oam_inrange_sp_backup)
@@ -767,6 +991,8 @@ __UINT_8 c_nes_ppu :: read_byte (__UINT_16 address)
 
         case 0x07:
         {
+            // Moves the VRAM address
+            ppu_writes++;
             if (!info.is_v_blank
                 && get_flag (CTL_2, BIT_4 | BIT_3))
             {
@@ -828,6 +1054,7 @@ __UINT_8 c_nes_ppu :: read_byte (__UINT_16 address)
 
 void c_nes_ppu :: write_byte (__UINT_16 address, __UINT_8 value)
 {
+    ppu_writes++;
     switch (address & 7)
     {
         case 0x07:
@@ -944,6 +1171,10 @@ void c_nes_ppu :: write_byte (__UINT_16 address, __UINT_8 value)
                 nes->o_cpu->request_secondary_nmi ();
             }
 
+            if ((registers [CTL_1] ^ value) & BIT_5)
+            {
+                is_sprite_lines_dirty = TRUE;
+            }
             registers [CTL_1] = value;
             info.bg_pattern_base = (value & BIT_4) << 8;
             info.sp_pattern_base = (value & BIT_3) << 9;
@@ -960,16 +1191,19 @@ void c_nes_ppu :: swap_page (__UINT_16 dest_where, __UINT_16 page_number, e_page
 //  if (nes->o_cpu->is_tracer_on ()) nes->general_log.f_write ("sbsws", "PPU: Page ", page_number, " swapped at ", dest_where, "\r\n");
 
     is_chr_rom = TRUE;
+    ppu_writes++;
     // divide by 1024
     dest_where >>= 10;
     __UINT_32 uiRealSize = size >> 10;
     pattern_pages_backup [dest_where] = page_number * uiRealSize;
-    pattern_pages [dest_where++] = &CHRROM [page_number * size];
+    pattern_pages [dest_where] = &CHRROM [page_number * size];
+    dirty_pages &= ~(1 << dest_where++);
 
     for (__UINT_8 page = 1; page < uiRealSize; page ++, dest_where ++)
     {
         pattern_pages_backup [dest_where] = pattern_pages_backup [dest_where - 1] + 1;
         pattern_pages [dest_where] = pattern_pages [dest_where - 1] + _1K_;
+        dirty_pages &= ~(1 << dest_where);
     }
 }
 
@@ -982,6 +1216,7 @@ void c_nes_ppu :: swap_page (__UINT_8 **destination, __UINT_16 dest_where, __UIN
 //  if (nes->o_cpu->is_tracer_on ()) nes->general_log.f_write ("sbsws", "PPU: Page ", page_number, " swapped at ", dest_where, "\r\n");
 
     is_chr_rom = TRUE;
+    ppu_writes++;
     dest_where >>= 10;
     __UINT_32 uiRealSize = size >> 10;
     destination [dest_where ++] = &CHRROM [page_number * size];
@@ -1028,16 +1263,22 @@ void c_nes_ppu :: decode_chr_rom (void)
     }
 }
 
+// A CHR-ROM page is copied into VRAM the first time it's written to,
+// then stays mapped there until it's swapped
 void c_nes_ppu :: write_chr_ram (__UINT_16 address, __UINT_8 value)
 {   
-    is_chr_rom = FALSE;
+    __UINT_8 page = (address >> 10) & 7;
 
-    if (nes->o_rom->information ().chr_pages)
+    if (is_chr_rom)
     {
-        for (__UINT_8 page = 0; page < 8; page ++)
+        if (!(dirty_pages & (1 << page)))
         {
             VRAM.load_from (&CHRROM, pattern_pages_backup [page] * _1K_, page << 10, _1K_);
+            pattern_pages [page] = &VRAM [page << 10];
+            dirty_pages |= 1 << page;
         }
+        pattern_pages [page] [address & 0x3ff] = value;
+        return;
     }
 
     VRAM [address] = value;
@@ -1047,7 +1288,11 @@ __UINT_8 c_nes_ppu :: read_chr_ram (__UINT_16 address)
 {
     if (is_chr_rom)
     {
-        return read_pattern_byte (address);
+        if (_2A03_get_label_holder () && !(dirty_pages & (1 << ((address >> 10) & 7))))
+        {
+            log_chr (pattern_pages [(address >> 10) & 7] + (address & 0x3ff), CDL_CHR_READ);
+        }
+        return pattern_pages [(address >> 10) & 7] [address & 0x3ff];
     }
     else
     {
@@ -1061,6 +1306,18 @@ void c_nes_ppu :: save_state (c_tracer &o_writer, e_save_state Type)
     {
         case MAIN:
             OAM.dump_to (o_writer, NULL, 0x000, 0x100, BINARY);
+            // The pages which weren't written hold their CHR-ROM contents,
+            // so load_state () can tell the written ones apart
+            if (is_chr_rom)
+            {
+                for (__UINT_8 index = 0; index < 8; index ++)
+                {
+                    if (!(dirty_pages & (1 << index)))
+                    {
+                        VRAM.load_from (&CHRROM, pattern_pages_backup [index] * _1K_, index << 10, _1K_);
+                    }
+                }
+            }
             VRAM.dump_to (o_writer, NULL, 0x0000, _16K_, BINARY);
             break;
 
@@ -1090,6 +1347,7 @@ void c_nes_ppu :: load_state (c_tracer &o_reader, e_save_state Type)
     {
         case MAIN:
             o_reader.read (&OAM [0], 0x100);
+            is_sprite_lines_dirty = TRUE;
             o_reader.read (&VRAM [0], _16K_);
             break;
 
@@ -1110,11 +1368,22 @@ void c_nes_ppu :: load_state (c_tracer &o_reader, e_save_state Type)
             o_reader.read (registers, 8);
             o_reader.read (pattern_pages_backup, 16);
 
+            dirty_pages = 0;
             if (is_chr_rom)
             {
                 for (__UINT_8 index = 0; index < 8; index ++)
                 {
-                    pattern_pages [index] = &CHRROM [pattern_pages_backup [index] * _1K_];
+                    // The written pages were restored with the VRAM
+                    // (the dirty mask isn't saved to keep the format)
+                    if (memcmp (&VRAM [index << 10], &CHRROM [pattern_pages_backup [index] * _1K_], _1K_))
+                    {
+                        dirty_pages |= 1 << index;
+                        pattern_pages [index] = &VRAM [index << 10];
+                    }
+                    else
+                    {
+                        pattern_pages [index] = &CHRROM [pattern_pages_backup [index] * _1K_];
+                    }
                 }
             }
             
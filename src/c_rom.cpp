@@ -33,7 +33,7 @@
 /** External Data                                                            **/
 /******************************************************************************/
 
-extern c_machine *o_machine;
+extern __THREAD_LOCAL c_machine *o_machine;
 
 /******************************************************************************/
 /** Installer                                                                **/
@@ -19,6 +19,7 @@
     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 *******************************************************************************/
 
+#include <windows.h>
 #include <io.h>
 #include <stdarg.h> 
 #include <stdio.h>
@@ -27,20 +28,33 @@
 #include "include/c_tracer.h"
 #include "include/datatypes.h"
 
+static DWORD WINAPI tracer_writer_thread (LPVOID tracer)
+{
+    ((c_tracer *) tracer)->process_chunks ();
+    return 0;
+}
+
 c_tracer :: c_tracer ()
 {
     destination = __FILE;
     handle = NULL;
+    chunks = NULL;
+    writer_thread = NULL;
+    chunks_posted = NULL;
 }
 
 c_tracer :: c_tracer (const char *Path, EMode Mode, Edestination Type)
 {
+    chunks = NULL;
+    writer_thread = NULL;
+    chunks_posted = NULL;
     set_destination (Type);
     set_output_file (Path, Mode);
 }
 
 c_tracer :: ~c_tracer ()
 {
+    set_async (FALSE);
     if (destination == __FILE && handle)
     {
         fclose (handle);
@@ -72,8 +86,171 @@ __INT_32 c_tracer :: set_output_file (const char *sPath, EMode Type)
     return 0;
 }
 
+/******************************************************************************/
+/** set_async ()                                                             **/
+/**                                                                          **/
+/** The messages are gathered into chunks which are written by another      **/
+/** thread so the emulation never waits for the disk.                       **/
+/******************************************************************************/
+
+void c_tracer :: set_async (__BOOL status)
+{
+    if (status && !writer_thread)
+    {
+        __NEW_MEM_BLOCK (chunks, s_tracer_chunk, TRACER_CHUNKS);
+        filling = FALSE;
+        dropped = 0;
+        chunks_write = 0;
+        chunks_read = 0;
+        writer_stop = FALSE;
+        writer_idle = FALSE;
+        chunks_posted = CreateEventA (NULL, FALSE, FALSE, NULL);
+        if (chunks_posted)
+        {
+            writer_thread = CreateThread (NULL, 0, tracer_writer_thread, this, 0, NULL);
+        }
+        // Stay synchronous if it can't be started
+        if (!writer_thread)
+        {
+            if (chunks_posted)
+            {
+                CloseHandle ((HANDLE) chunks_posted);
+                chunks_posted = NULL;
+            }
+            __DELETE_MEM_BLOCK (chunks);
+            chunks = NULL;
+        }
+    }
+    else if (!status && writer_thread)
+    {
+        // Send the last one
+        flush ();
+        writer_stop = TRUE;
+        SetEvent ((HANDLE) chunks_posted);
+        WaitForSingleObject ((HANDLE) writer_thread, INFINITE);
+        CloseHandle ((HANDLE) writer_thread);
+        CloseHandle ((HANDLE) chunks_posted);
+        writer_thread = NULL;
+        chunks_posted = NULL;
+        __DELETE_MEM_BLOCK (chunks);
+        chunks = NULL;
+    }
+}
+
+/******************************************************************************/
+/** flush ()                                                                 **/
+/**                                                                          **/
+/** Publishes the chunk being filled even if it's not full (it's called at  **/
+/** each frame so the log never lags too much behind the emulation).       **/
+/******************************************************************************/
+
+void c_tracer :: flush (void)
+{
+    if (writer_thread && filling)
+    {
+        publish_chunk ();
+    }
+}
+
+void c_tracer :: publish_chunk (void)
+{
+    // Volatile stores are ordered (the chunk is filled before it's published)
+    chunks_write = chunks_write + 1;
+    filling = FALSE;
+    MemoryBarrier ();
+    if (writer_idle)
+    {
+        SetEvent ((HANDLE) chunks_posted);
+    }
+}
+
+// Writer thread
+void c_tracer :: process_chunks (void)
+{
+    s_tracer_chunk *chunk;
+    __UINT_32 last;
+    __UINT_32 stop;
+
+    for (;;)
+    {
+        // Everything was sent before the stop request
+        stop = writer_stop;
+        last = chunks_write;
+        if (chunks_read == last)
+        {
+            if (stop)
+            {
+                break;
+            }
+            // Check again once the producer can see we're waiting
+            writer_idle = TRUE;
+            MemoryBarrier ();
+            if (chunks_write == chunks_read && !writer_stop)
+            {
+                WaitForSingleObject ((HANDLE) chunks_posted, INFINITE);
+            }
+            writer_idle = FALSE;
+            continue;
+        }
+        while (chunks_read != last)
+        {
+            chunk = &chunks [chunks_read & (TRACER_CHUNKS - 1)];
+            fwrite (chunk->data, 1, chunk->size, handle);
+            chunks_read = chunks_read + 1;
+        }
+    }
+}
+
+void c_tracer :: append (const char *data, __UINT_32 size)
+{
+    s_tracer_chunk *chunk;
+    __UINT_32 part;
+
+    while (size)
+    {
+        if (!filling)
+        {
+            // All the chunks are waiting for the writer
+            if ((chunks_write - chunks_read) >= TRACER_CHUNKS)
+            {
+                dropped++;
+                return;
+            }
+            chunk = &chunks [chunks_write & (TRACER_CHUNKS - 1)];
+            chunk->size = 0;
+            if (dropped)
+            {
+                chunk->size = sprintf (chunk->data, "Tracer: WARNING: %u message(s) dropped.\r\n", dropped);
+                dropped = 0;
+            }
+            filling = TRUE;
+        }
+        chunk = &chunks [chunks_write & (TRACER_CHUNKS - 1)];
+        part = TRACER_CHUNK_SIZE - chunk->size;
+        if (part > size)
+        {
+            part = size;
+        }
+        memcpy (chunk->data + chunk->size, data, part);
+        chunk->size += part;
+        data += part;
+        size -= part;
+        if (chunk->size == TRACER_CHUNK_SIZE)
+        {
+            publish_chunk ();
+        }
+    }
+    // Don't keep the writer waiting for a full chunk
+    // (once it's done with the others)
+    if (filling && writer_idle && chunks_read == chunks_write)
+    {
+        publish_chunk ();
+    }
+}
+
 void c_tracer :: close (void)
 {
+    set_async (FALSE);
     if (handle)
     {
         fclose (handle);
@@ -148,7 +325,14 @@ void c_tracer :: f_write (const char *sArgDescription, ...)
 
     if(handle)
     {
-        fwrite (Buffer, sizeof (__UINT_8), strlen (Buffer), handle);
+        if (writer_thread)
+        {
+            append (Buffer, (__UINT_32) strlen (Buffer));
+        }
+        else
+        {
+            fwrite (Buffer, sizeof (__UINT_8), strlen (Buffer), handle);
+        }
     }
 
     va_end (vl);
@@ -184,5 +368,10 @@ void c_tracer :: write (void *buffer, __UINT_32 size)
     {
         return;
     }
+    if (writer_thread)
+    {
+        append ((const char *) buffer, size);
+        return;
+    }
     fwrite (buffer, 1, size, handle);
 }
@@ -24,6 +24,102 @@
 
 #include "datatypes.h"
 
+/******************************************************************************/
+/** Context                                                                  **/
+/******************************************************************************/
+
+struct s_2A03_block;
+struct s_2A03_dynarec;
+
+// Instruction decoded from the PRG-ROM, it's indexed by rom offset
+// so it stays valid whatever the banks mapping
+struct s_2A03_decoded
+{
+	__UINT_32 cycles;
+	__UINT_16 operand;
+	__UINT_8 opcode;
+	__UINT_8 is_valid;
+	// Its memory access has to fit in the time slice
+	__UINT_8 has_access;
+	// CDL windows it was already logged from
+	__UINT_8 code_windows;
+	// Translated code starting there (see 2a03_dynarec.cpp)
+	s_2A03_block *block;
+};
+
+// Complete state of a 2A03 (each c_nes_cpu owns one)
+struct s_2A03_context
+{
+	__BOOL instructionDumper, instructionLog, labelHolder,
+		   IRQLine, IRQRequested, NMIRequested, NMISecondRequested,
+		   unfinishedOp;
+	// Set when the interrupts have to be checked again
+	__BOOL events;
+	// Running ahead of the PPU (cleared by the core when it stops
+	// before an access the PPU has to catch up for)
+	__BOOL run_ahead;
+	__UINT_8 S, X, Y, tmpByte, SP;
+	__UINT_16 A, tmpAddress, IRQAddr, NMIAddr, resetAddr;
+	AWORD PC, tmpWord;
+	// Operand bytes of the current instruction
+	__UINT_16 operand;
+	__INT_32 tmpInt;
+	__INT_32 iCurrentTime, iEndTime;
+
+	// Jump tables detection
+	int base_addr, idx_addr, jump_addr, last_x, last_y;
+
+	__UINT_32 *cycleCounts;
+	__UINT_32 PPUCycleCounts [0x100];
+	__INT_32 *accessCycles;
+	__INT_32 PPUAccessCycles [0x100];
+
+	// Allocated by the cpu (one entry per PRG-ROM byte)
+	s_2A03_decoded *decoded;
+	__INT_32 decoded_size;
+	s_2A03_dynarec *dynarec;
+
+	// Core matching the tracing features in use
+	void (*run) (void);
+};
+
+// Context of the machine running in the current thread
+extern __THREAD_LOCAL s_2A03_context *_2A03_cpu;
+
+extern void _2A03_init_context (s_2A03_context *context);
+extern void _2A03_set_context (s_2A03_context *context);
+
+// State of the current context used outside of the core
+__inline __BOOL _2A03_get_label_holder (void)
+{
+	return _2A03_cpu->labelHolder;
+}
+
+__inline __UINT_16 _2A03_get_reset_address (void)
+{
+	return _2A03_cpu->resetAddr;
+}
+
+__inline __UINT_16 _2A03_get_irq_address (void)
+{
+	return _2A03_cpu->IRQAddr;
+}
+
+__inline __UINT_16 _2A03_get_nmi_address (void)
+{
+	return _2A03_cpu->NMIAddr;
+}
+
+__inline void _2A03_set_run_ahead (__BOOL status)
+{
+	_2A03_cpu->run_ahead = status;
+}
+
+__inline __BOOL _2A03_is_running_ahead (void)
+{
+	return _2A03_cpu->run_ahead;
+}
+
 /******************************************************************************/
 /** Execution                                                                **/
 /******************************************************************************/
@@ -39,8 +135,6 @@ extern void _2A03_set_irq_line (__BOOL);
 extern __BOOL _2A03_getIRQLine (void);
 
 extern __UINT_8 _2A03_get_interrupt_flag (void);
-extern __BOOL _2A03_labelHolder;
-extern __UINT_16 IRQAddr, NMIAddr, resetAddr;
 
 /******************************************************************************/
 /** Timing                                                                   **/
@@ -87,6 +181,9 @@ extern int _2A03_map_instruction (int base_addr,
 								  int sub_type);
 
 class c_tracer;
+struct s_trace_record;
+
+extern void _2A03_render_trace_record (c_tracer &out, s_trace_record *record);
 
 extern void _2A03_save_state (c_tracer &TDump);
 extern void _2A03_load_state (c_tracer &TDump);
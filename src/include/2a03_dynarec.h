@@ -0,0 +1,75 @@
+/*******************************************************************************
+    crudNES - A NES emulator for reverse engineering purposes
+	2A03 Blocks Translator
+    Copyright (C) 2023-2024 Franck "hitchhikr" Charlet
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*******************************************************************************/
+
+#ifndef _2A03_DYNAREC_H
+#define _2A03_DYNAREC_H
+
+#include "datatypes.h"
+
+// The blocks are translated to x86-32 code
+#if defined(_M_IX86) || defined(__i386__)
+#define _2A03_DYNAREC
+#endif
+
+struct s_2A03_context;
+
+// Straight PRG-ROM code translated to host code
+struct s_2A03_block
+{
+	// Address it was translated at
+	__UINT_16 address;
+	// Returns the number of instructions it ran
+	// (NULL if the interpreter has to run the first one)
+	int (*run) (void);
+};
+
+#ifdef _2A03_DYNAREC
+
+extern void _2A03_dynarec_init(s_2A03_context *context,
+                               __UINT_8 **read_pages,
+                               __UINT_8 **write_pages,
+                               __UINT_8 *ram);
+extern void _2A03_dynarec_free(s_2A03_context *context);
+extern void _2A03_dynarec_flush(s_2A03_context *context);
+extern s_2A03_block *_2A03_dynarec_translate(s_2A03_context *context,
+                                             __UINT_16 address,
+                                             const __UINT_8 *code,
+                                             int length);
+
+#else
+
+__inline void _2A03_dynarec_init(s_2A03_context *context,
+                                 __UINT_8 **read_pages,
+                                 __UINT_8 **write_pages,
+                                 __UINT_8 *ram)
+{
+}
+
+__inline void _2A03_dynarec_free(s_2A03_context *context)
+{
+}
+
+__inline void _2A03_dynarec_flush(s_2A03_context *context)
+{
+}
+
+#endif
+
+#endif
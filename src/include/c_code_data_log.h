@@ -0,0 +1,75 @@
+/*******************************************************************************
+    crudNES - A NES emulator for reverse engineering purposes
+    Code/Data Logger
+    Copyright (C) 2023-2024 Franck "hitchhikr" Charlet
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*******************************************************************************/
+
+#ifndef _CCODEDATALOG_H
+#define _CCODEDATALOG_H
+
+#include "datatypes.h"
+
+/******************************************************************************/
+/** Flags (same layout as the FCEUX .cdl files)                              **/
+/******************************************************************************/
+
+#define CDL_PRG_CODE BIT_0
+#define CDL_PRG_DATA BIT_1
+#define CDL_PRG_WINDOW (BIT_2 | BIT_3)
+#define CDL_PRG_INDIRECT_CODE BIT_4
+#define CDL_PRG_INDIRECT_DATA BIT_5
+#define CDL_PRG_PCM BIT_6
+
+#define CDL_CHR_RENDERED BIT_0
+#define CDL_CHR_READ BIT_1
+
+class c_code_data_log
+{
+	public:
+
+		c_code_data_log (__INT_32 prg_rom_size, __INT_32 chr_rom_size);
+		~c_code_data_log (void);
+
+		// Offsets are relative to the start of the PRG-ROM,
+		// address is the cpu address it was accessed from
+		void log_prg (__INT_32 offset, __UINT_16 address, __UINT_8 flags)
+		{
+			if ((__UINT_32) offset < (__UINT_32) prg_size)
+			{
+				prg [offset] |= flags | ((address >> 11) & CDL_PRG_WINDOW);
+			}
+		}
+		void log_chr (__INT_32 offset, __UINT_8 flags)
+		{
+			if ((__UINT_32) offset < (__UINT_32) chr_size)
+			{
+				chr [offset] |= flags;
+			}
+		}
+
+		void load (const char *filename);
+		void save (const char *filename);
+
+	private:
+
+		__UINT_8 *prg;
+		__UINT_8 *chr;
+		__INT_32 prg_size;
+		__INT_32 chr_size;
+};
+
+#endif
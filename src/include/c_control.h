@@ -29,13 +29,24 @@
 /** External Data                                                            **/
 /******************************************************************************/
 
-extern c_machine *o_machine;
+extern __THREAD_LOCAL c_machine *o_machine;
 
 enum NESControlList
 {
 	APU = 1, DMA = 2
 };
 
+// A Game Genie code applied to a single address
+struct s_genie_patch
+{
+	__UINT_16 address;
+	__UINT_8 data;
+	__UINT_8 compare;
+	__BOOL has_compare;
+	// Order of the code on the command line
+	int order;
+};
+
 class c_nes_control
 {
 	public:
@@ -43,10 +54,66 @@ class c_nes_control
 		c_nes_control (void);
 		~c_nes_control (void);
 		
-		__UINT_8 read_byte (__UINT_16 address);
+		// RAM, SRAM and PRG-ROM are accessed directly through the pages
+		// table, everything else goes through the registers handlers
+		__UINT_8 read_byte (__UINT_16 address)
+		{
+			__UINT_8 *page = read_pages [address >> 8];
+
+			if (page)
+			{
+				return page [address & 0xff];
+			}
+			return read_unmapped (address);
+		}
 		__UINT_16 read_word (__UINT_16 address);
 
-		void write_byte (__UINT_16 address, __UINT_8 value);
+		void write_byte (__UINT_16 address, __UINT_8 value)
+		{
+			__UINT_8 *page = write_pages [address >> 8];
+
+			if (page)
+			{
+				page [address & 0xff] = value;
+				return;
+			}
+			write_unmapped (address, value);
+		}
+
+		void map_prg_window (__UINT_8 window, __UINT_8 *source);
+		__BOOL is_mapped (__UINT_16 address)
+		{
+			return read_pages [address >> 8] != NULL;
+		}
+		__BOOL is_write_mapped (__UINT_16 address)
+		{
+			return write_pages [address >> 8] != NULL;
+		}
+		__UINT_8 **get_read_pages (void)
+		{
+			return read_pages;
+		}
+		__UINT_8 **get_write_pages (void)
+		{
+			return write_pages;
+		}
+		// TRUE if a Game Genie patches one of the bytes
+		__BOOL is_patched (__UINT_16 address, int length)
+		{
+			if (!nbr_genie_patches)
+			{
+				return FALSE;
+			}
+			while (length--)
+			{
+				if (address > 0x7fff && (genie_bits [(address & 0x7fff) >> 3] & (1 << (address & 7))))
+				{
+					return TRUE;
+				}
+				address ++;
+			}
+			return FALSE;
+		}
 
 		void save_state (c_tracer o_writer)
 		{
@@ -61,10 +128,25 @@ class c_nes_control
 		}
 
 	private:
+		void build_genie_patches (void);
+		__UINT_8 read_genie (__UINT_16 address);
+		__UINT_8 read_unmapped (__UINT_16 address);
+		void write_unmapped (__UINT_16 address, __UINT_8 value);
 		__UINT_8 ApuDmaReadByte (const __UINT_16 &);
 		void ApuDmawrite_byte (const __UINT_16 &, const __UINT_8 &);
 
 		__UINT_8 *control [3];
+
+		// One entry per 256 bytes page (NULL when it needs a handler)
+		__UINT_8 *read_pages [0x100];
+		__UINT_8 *write_pages [0x100];
+		// Pages patched by a Game Genie
+		__BOOL genie_pages [0x100];
+		// One bit per PRG-ROM address patched by a Game Genie
+		__UINT_8 genie_bits [0x8000 / 8];
+		// Sorted by address
+		s_genie_patch *genie_patches;
+		int nbr_genie_patches;
 };
 
 #endif
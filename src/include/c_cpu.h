@@ -40,7 +40,7 @@
 /** External Data                                                            **/
 /******************************************************************************/
 
-extern c_machine *o_machine;
+extern __THREAD_LOCAL c_machine *o_machine;
 extern void irq_notifier (void *);
 
 class c_nes_cpu
@@ -82,7 +82,22 @@ class c_nes_cpu
 
 		__INT_32 earliest_event_before (__INT_32 iEndTime);
 
-		void run_cycles (__INT_32 cycles);
+		// Called by the PPU every few pixels, most of the time the cpu
+		// is still ahead after its last instruction and nothing runs
+		void run_cycles (__INT_32 cycles)
+		{
+			ideal_time += cycles * cycle_multiplier;
+			if (_2A03_cpu->iCurrentTime < ideal_time)
+			{
+				run_until (ideal_time);
+			}
+		}
+		// Time of an event the given number of PPU cycles from now
+		__INT_32 event_time (__INT_32 cycles)
+		{
+			return ideal_time + cycles * cycle_multiplier;
+		}
+		void run_ahead (__INT_32 time);
 		void apu_catch_up (void) { nes->o_apu.run_until (_2A03_get_current_time () / (3*16)); }
 
 		void end_time_frame (__INT_32 end_time)
@@ -91,6 +106,7 @@ class c_nes_cpu
 			nes->o_blip.end_frame (_2A03_get_current_time () / (3*16));
 			_2A03_set_current_time (_2A03_get_current_time () - end_time);
 			ideal_time -= end_time;
+			held_time = -1;
 		}
 
 		void toggle_logtracer (void)
@@ -182,6 +198,10 @@ class c_nes_cpu
 
 	private:
 
+		void update_prg_mapping (void);
+		void run_until (__INT_32 time);
+
+		s_2A03_context context;
 		__UINT_8 is_frame_even;
 		__UINT_8 *PRGRAM [8];
 		__UINT_16 pages [8];
@@ -189,6 +209,8 @@ class c_nes_cpu
 		__INT_32 sampling_rate, bits_per_sample, frame_rate;
 		__UINT_32 last_line;
 		__UINT_32 cycle_multiplier;
+		// Time the cpu last stopped running ahead of the PPU
+		__INT_32 held_time;
 
 		AUDIOSTREAM *audio_stream;
 };
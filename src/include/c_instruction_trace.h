@@ -0,0 +1,108 @@
+/*******************************************************************************
+    crudNES - A NES emulator for reverse engineering purposes
+    Instructions Trace
+    Copyright (C) 2023-2024 Franck "hitchhikr" Charlet
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*******************************************************************************/
+
+#ifndef _CINSTRUCTIONTRACE_H
+#define _CINSTRUCTIONTRACE_H
+
+#include <stdio.h>
+#include <string.h>
+
+#include "datatypes.h"
+
+class c_tracer;
+
+#define TRACE_BUFFER_RECORDS 65536
+
+/******************************************************************************/
+/** Record of an executed instruction                                        **/
+/******************************************************************************/
+
+// Markers are rendered as the lines the logger wrote between the instructions
+enum e_trace_kind
+{
+	TRACE_INSTRUCTION = 0,
+	TRACE_NEW_FRAME,
+	TRACE_SCANLINE,
+	TRACE_HBLANK,
+	TRACE_VBLANK,
+	TRACE_NMI_VECTOR,
+	TRACE_RESET_VECTOR,
+	TRACE_IRQ_VECTOR
+};
+
+struct s_trace_record
+{
+	// Cycles left in the time slice
+	__INT_32 cycle;
+	// Scanline or vector address for the markers
+	__UINT_16 pc;
+	// What the logger displayed after the operand
+	__UINT_16 pointer;
+	__UINT_8 value;
+	__UINT_8 bank;
+	__UINT_8 opcode [3];
+	__UINT_8 a, x, y, s, sp;
+	__UINT_8 kind;
+};
+
+class c_instruction_trace
+{
+	public:
+
+		c_instruction_trace (void);
+		~c_instruction_trace (void);
+
+		void set_output_file (const char *filename);
+		void close (void);
+
+		// Records are written by large blocks
+		s_trace_record *add_record (void)
+		{
+			if (nbr_records == max_records)
+			{
+				flush ();
+			}
+			return &records [nbr_records++];
+		}
+		void add_marker (__UINT_8 kind, __UINT_16 value)
+		{
+			s_trace_record *record = add_record ();
+
+			memset (record, 0, sizeof (s_trace_record));
+			record->kind = kind;
+			record->pc = value;
+		}
+
+		// Converts a trace to the text format of the logger
+		static __BOOL render (const char *filename, const char *output);
+
+	private:
+
+		void flush (void);
+		static void render_marker (c_tracer &out, s_trace_record *record);
+
+		FILE *handle;
+		char name [1024];
+		s_trace_record *records;
+		__INT_32 nbr_records;
+		__INT_32 max_records;
+};
+
+#endif
@@ -38,26 +38,29 @@ enum e_dattype
 	TYPE_DEAD = 7
 };
 
+// Fields are ordered by size to keep the record packed
 struct s_label_node
 {
-    __UINT_8 bank;
-    __UINT_16 address;
-	e_dattype type;
-	e_dattype sub_type;
+	s_label_node *Next;
+	// Next label sharing the same address
+	s_label_node *Next_Address;
+    int offset;
+	int rom_offset;
     union
     {
 	    __UINT_16 contents;
 	    __UINT_16 size;
     };
-    int offset;
-    int bank_lo;
-    int bank_hi;
-    int alias;
-	int real_bank;
-	int rom_offset;
-	int ref_bank;
+    __UINT_16 address;
 	__UINT_16 jump_base_table;
-	s_label_node *Next;
+    __INT_16 bank_lo;
+    __INT_16 bank_hi;
+    __INT_16 alias;
+	__INT_16 real_bank;
+	__INT_16 ref_bank;
+    __UINT_8 bank;
+	__UINT_8 type;
+	__UINT_8 sub_type;
 
     void operator = (s_label_node *source)
     {
@@ -91,6 +94,7 @@ struct s_label_node
             new_label->rom_offset = rom_offset;
 			new_label->ref_bank = -1;
             new_label->Next = 0;
+            new_label->Next_Address = 0;
     		holder->Next = new_label;
             return(new_label);
         }
@@ -107,12 +111,166 @@ struct s_label_node
             holder->rom_offset = rom_offset;
 			holder->ref_bank = -1;
             holder->Next = 0;
+            holder->Next_Address = 0;
             return(holder);
         }
     }
 
 };
 
+// Labels are allocated by chunks which never move (the nodes addresses
+// are stable) and they're all released at once
+#define LABEL_POOL_CHUNK 4096
+
+class c_label_pool
+{
+	public:
+
+		c_label_pool (void)
+		{
+			chunks = NULL;
+			nbr_chunks = 0;
+			max_chunks = 0;
+			current = 0;
+			used = LABEL_POOL_CHUNK;
+		}
+		~c_label_pool (void)
+		{
+			int i;
+
+			for(i = 0; i < nbr_chunks; i++)
+			{
+				__DELETE_MEM_BLOCK(chunks[i]);
+			}
+			__DELETE_MEM_BLOCK(chunks);
+		}
+
+		s_label_node *alloc (void)
+		{
+			if(used == LABEL_POOL_CHUNK)
+			{
+				next_chunk();
+			}
+			return &chunks[current - 1][used++];
+		}
+
+		// The chunks are kept for the next labels
+		void clear (void)
+		{
+			current = 0;
+			used = LABEL_POOL_CHUNK;
+		}
+
+	private:
+
+		void next_chunk (void)
+		{
+			s_label_node **new_chunks;
+
+			if(current == nbr_chunks)
+			{
+				if(nbr_chunks == max_chunks)
+				{
+					max_chunks += 64;
+					__NEW_MEM_BLOCK(new_chunks, s_label_node *, max_chunks);
+					if(chunks)
+					{
+						memcpy(new_chunks, chunks, nbr_chunks * sizeof(s_label_node *));
+						__DELETE_MEM_BLOCK(chunks);
+					}
+					chunks = new_chunks;
+				}
+				__NEW_MEM_BLOCK(chunks[nbr_chunks], s_label_node, LABEL_POOL_CHUNK);
+				nbr_chunks++;
+			}
+			current++;
+			used = 0;
+		}
+
+		s_label_node **chunks;
+		int nbr_chunks;
+		int max_chunks;
+		int current;
+		int used;
+};
+
+// Kinds of labels an instruction can report
+enum e_site_kind
+{
+	SITE_DATA = BIT_0,
+	SITE_BRANCH = BIT_1,
+	SITE_JUMP = BIT_2,
+	SITE_POINTER = BIT_3,
+	SITE_END = BIT_4
+};
+
+// Label reported by the emulation, everything depending
+// on the current mapping is already resolved
+enum e_label_event_kind
+{
+	EVENT_LABEL = 0,
+	EVENT_LABEL_BANK
+};
+
+struct s_label_event
+{
+	__UINT_8 kind;
+	__UINT_8 bank;
+	__UINT_8 type;
+	__UINT_8 sub_type;
+	__UINT_16 value;
+	__UINT_16 force;
+	int base;
+	int ref_bank;
+	int offset;
+	int old_bank;
+};
+
+// Must be a power of 2
+#define LABEL_EVENTS_SIZE 0x10000
+
+// A label as it is stored in the labels file
+struct s_label_record
+{
+	int offset;
+	int real_bank;
+	int alias;
+	int contents;
+	int type;
+	int sub_type;
+	int jump_base_table;
+	int ref_bank;
+	int duplicate;
+};
+
+// Binary labels database
+#define LABELS_DB_MAGIC "CLDB"
+#define LABELS_DB_VERSION 1
+
+struct s_label_db_header
+{
+	char magic[4];
+	__UINT_32 version;
+	__UINT_32 record_size;
+	__UINT_32 nbr_records;
+};
+
+struct s_label_db_record
+{
+	__INT_32 offset;
+	// -1 when unknown, like in the labels
+	__INT_16 real_bank;
+	__INT_16 alias;
+	__UINT_16 contents;
+	__UINT_8 type;
+	__UINT_8 sub_type;
+	__UINT_16 jump_base_table;
+	__INT_16 ref_bank;
+};
+
+struct s_bank_job;
+class c_machine;
+
 class c_label_holder
 {
 	public:
@@ -125,6 +283,16 @@ class c_label_holder
         int insert_label_bank (__UINT_8 bank, __UINT_16 value,
                                e_dattype type, e_dattype sub_type,
                                int force, int base, int ref_bank, int offset, int old_bank = -1, int jmp_pos = -1);
+        void queue_label_bank (__UINT_8 bank, __UINT_16 value,
+                               e_dattype type, e_dattype sub_type,
+                               int force, int base, int ref_bank, int offset, int old_bank = -1);
+		void flush_labels(void);
+		void process_events(void);
+		void run_bank_jobs(void);
+		c_machine *get_machine(void)
+		{
+			return machine;
+		}
 		s_label_node *search_page(int address);
 		int is_current_page(int bank, int address);
 		int fix_var_bank(int value, int ref_bank);
@@ -134,6 +302,11 @@ class c_label_holder
 		s_label_node *get_page_from_bank(int bank);
 		int get_bank_alias(int bank, int value);
 		int get_real_bank(int alias);
+		s_label_node *alloc_label(void)
+		{
+			return labels.alloc();
+		}
+		int is_new_site(__UINT_16 address, int kind, __UINT_16 target);
 
 		void dump_rom(void);
         s_label_node *search_label(int bank_lo,
@@ -146,8 +319,68 @@ class c_label_holder
 
 	private:
 
+		void link_label(s_label_node *label);
+		void add_label(__UINT_16 value, e_dattype type, e_dattype sub_type,
+		               int force, int base, int ref_bank, int bank, int offset);
+		void start_events(void);
+		void post_event(s_label_event *event);
+		void apply_event(s_label_event *event);
+		void load_labels_text(void);
+		void save_labels_text(void);
+		int load_labels_db(void);
+		void save_labels_db(void);
+		void build_page_tables(void);
+		void free_page_tables(void);
+		int generate_prg_bank(s_bank_job *job);
+		void generate_chr_bank(s_bank_job *job);
+		void start_bank_jobs(int first, int last, int done_vectors);
+
+		c_label_pool labels;
+		// Machine owning the labels
+		c_machine *machine;
+		// Last label created or turned into code by insert_label_bank()
+		int changed_address;
+		int changed_alias;
 		s_label_node *head;
-		s_label_node unknown;
+		s_label_node *tail;
+		// Labels indexed by address (in insertion order)
+		s_label_node **address_heads;
+		s_label_node **address_tails;
+		// Incremented each time a label is created or modified
+		__UINT_32 label_changes;
+
+		// Banks being disassembled by the threads
+		s_bank_job *bank_jobs;
+		volatile long next_bank_job;
+		int last_bank_job;
+
+		// Kinds already reported by each PRG-ROM byte, valid while the
+		// target and the return address (2 keys per byte) keep their banks
+		__UINT_8 *visited_sites;
+		__UINT_32 *visited_keys;
+		int prg_size;
+
+		// Labels reported while the emulation runs are inserted
+		// by a separate thread (single producer/single consumer),
+		// started with the first label reported
+		s_label_event *events;
+		volatile __UINT_32 events_write;
+		volatile __UINT_32 events_read;
+		volatile __UINT_32 events_stop;
+		// Set by the side waiting for the other one
+		volatile __UINT_32 events_idle;
+		volatile __UINT_32 events_full;
+		void *events_thread;
+		void *events_posted;
+		void *events_freed;
+
+		// Pages lookup tables (4k granularity), only valid while disassembling
+		int page_tables;
+		int max_page_alias;
+		s_label_node *bank_pages[256 * 16];
+		s_label_node *address_pages[16];
+		s_label_node **alias_pages;
+		__UINT_8 *alias_slots;
 
 };
 
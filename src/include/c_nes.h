@@ -29,6 +29,8 @@
 #include "c_tracer.h"
 #include "c_machine.h"
 #include "c_label_holder.h"
+#include "c_code_data_log.h"
+#include "c_instruction_trace.h"
 
 class c_save_state;
 class c_label_holder;
@@ -43,6 +45,7 @@ class c_mem_block;
 class c_mapper;
 class c_save_state;
 class c_tracer;
+class c_code_data_log;
 
 class c_nes : public c_machine
 {
@@ -64,6 +67,11 @@ class c_nes : public c_machine
 		void set_instruction_dumper (__BOOL o_state);
 		void set_label_holder (__BOOL o_state);
 		void set_log_tracer (__BOOL o_state);
+		void set_dynarec (__BOOL o_state);
+		__BOOL is_dynarec_on (void)
+		{
+			return dynarec;
+		}
 
 		void set_sram (const char *Path);
 		void dump_header (const char *Path);
@@ -83,11 +91,13 @@ class c_nes : public c_machine
 		c_mapper *o_mapper;
 		c_save_state *o_state;
 		c_label_holder *BankJMPList;
+		c_code_data_log *o_cdl;
 
 		Nes_Apu o_apu;
 		Blip_Buffer o_blip;
 
 		c_tracer general_log;
+		c_instruction_trace instruction_trace;
 		c_tracer TJumpTableLog;
 		
 		int is_mmc2_vrom;
@@ -95,11 +105,15 @@ class c_nes : public c_machine
         s_label_node *chr_pages;
 
 		char Labels_Name[1024];
+		char Labels_DB_Name[1024];
+		char CDL_Name[1024];
 		char Game_Name[1024];
 		char Game_FileName[1024];
 
 	private:
 
+		__BOOL log_tracer;
+		__BOOL dynarec;
 };
 
 #endif
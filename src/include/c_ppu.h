@@ -64,16 +64,13 @@
 	destinationArray [7] = uiSrc & 3; \
 }
 
+// Interleaves both bitplanes of a tileline, 4 pixels per store
 #define _2C02_UNPACK_TILELINE_SLOW(bSrcLow,bSrcHigh,destinationArray) \
 { \
-	destinationArray [0] = (((bSrcHigh & 128) >> 6) | ((bSrcLow & 128) >> 7)); \
-	destinationArray [1] = (((bSrcHigh & 64) >> 5)  | ((bSrcLow & 64) >> 6) ); \
-	destinationArray [2] = (((bSrcHigh & 32) >> 4)  | ((bSrcLow & 32) >> 5) ); \
-	destinationArray [3] = (((bSrcHigh & 16) >> 3)  | ((bSrcLow & 16) >> 4) ); \
-	destinationArray [4] = (((bSrcHigh & 8) >> 2)   | ((bSrcLow & 8) >> 3)  ); \
-	destinationArray [5] = (((bSrcHigh & 4) >> 1)   | ((bSrcLow & 4) >> 2)  ); \
-	destinationArray [6] = ((bSrcHigh  & 2)         | ((bSrcLow & 2) >> 1)  ); \
-	destinationArray [7] = ((bSrcHigh & 1) << 1)    | ((bSrcLow & 1)        ); \
+	((__UINT_32 *) (destinationArray)) [0] = c_nes_ppu :: tileline_spread [bSrcLow] [0] | \
+	                                         (c_nes_ppu :: tileline_spread [bSrcHigh] [0] << 1); \
+	((__UINT_32 *) (destinationArray)) [1] = c_nes_ppu :: tileline_spread [bSrcLow] [1] | \
+	                                         (c_nes_ppu :: tileline_spread [bSrcHigh] [1] << 1); \
 }
 
 #define _2C02_NES_COLOR(Cast,Palette,uiIndex) ((Cast) (emulator_palette [Palette [uiIndex] & info.monochrome]))
@@ -273,6 +270,7 @@ class c_nes_ppu
 		void set_mirroring (__UINT_8 mode)
 		{
 			state_changed = TRUE;
+			ppu_writes++;
 			mirroring_mode = mode;
 
 			nametables [0] = &VRAM [mirroring_modes [mode] [0]];
@@ -284,6 +282,7 @@ class c_nes_ppu
 		void set_mirroring (__UINT_32 nametable, __UINT_8 *Area)
 		{
 			state_changed = TRUE;
+			ppu_writes++;
 			
 			nametables [nametable] = Area;
 		}
@@ -338,6 +337,7 @@ class c_nes_ppu
 		void oam_dma (c_mem_block *source, __UINT_16 where_in_source)
 		{
 			OAM.load_from (source, where_in_source, 0x00, 0x100);
+			is_sprite_lines_dirty = TRUE;
 		}
 
 		__UINT_8 read_oam_byte (void)
@@ -347,6 +347,7 @@ class c_nes_ppu
 		void write_oam_byte (__UINT_8 value)
         {
             OAM.write_byte (oam_address ++, value);
+			is_sprite_lines_dirty = TRUE;
         }
 		void set_oam_address (__UINT_8 value)
         {
@@ -376,11 +377,23 @@ class c_nes_ppu
         }
 
 		void FetchObjectData (void);
+		void build_sprite_lines (void);
 
 		void EvaluateOAMEntry (void)
 		{
 			if (get_flag (CTL_2, BIT_3 | BIT_4))
 			{
+				// Only the sprites listed for the line need to be compared
+				if (!is_sprite_lines_dirty && info.scanline < 256)
+				{
+					if (oam_inrange_sp == sprite_lines_count [info.scanline] ||
+						(spr_ram_index >> 2) != sprite_lines [info.scanline] [oam_inrange_sp])
+					{
+						spr_ram_index += 4;
+						return;
+					}
+				}
+
 				__INT_16 y_difference = info.scanline - OAM [spr_ram_index];
 
 				if (y_difference < 0 || (y_difference > ((!get_flag (CTL_1, BIT_5)) ? 7 : 15)))
@@ -418,6 +431,11 @@ class c_nes_ppu
 		{
 			if (is_chr_rom)
             {
+                // (the written pages live in VRAM)
+                if (_2A03_get_label_holder () && !(dirty_pages & (1 << ((address >> 10) & 7))))
+                {
+                    log_chr (pattern_pages [(address >> 10) & 7] + (address & 0x3ff), CDL_CHR_RENDERED);
+                }
                 return pattern_pages [(address >> 10) & 7] [address & 0x3ff];
             }
 			else
@@ -430,6 +448,10 @@ class c_nes_ppu
 		{
 			if (source [(address >> 10) & 3])
             {
+                if (_2A03_get_label_holder ())
+                {
+                    log_chr (source [(address >> 10) & 3] + (address & 0x3ff), CDL_CHR_RENDERED);
+                }
 				return source [(address >> 10) & 3] [address & 0x3ff];
             }
 			else
@@ -551,11 +573,23 @@ class c_nes_ppu
 			return FALSE;
 		}
 
+		// What the next read of $2002 will return (up to the given time)
+		__UINT_8 peek_status (void)
+		{
+			return registers [STAT];
+		}
+		__INT_32 status_stable_until (void)
+		{
+			return IsEventPending (POC) ? info.po_collision_cycle : 0x7fffffff;
+		}
+
         c_mem_block CHRROM;
 
     private:
 
 		void render_bg_tileline16 (void);
+		void draw_bg_tile (__UINT_16 *destination, __UINT_8 *solid);
+		void compose_bg_tile (__UINT_16 *destination, __UINT_8 *solid);
 
 		void render_bg_tileline_fh_16 (__UINT_16 y_offset, __UINT_16 tileline, __UINT_32 attribute, __UINT_8 x_start, __UINT_8 x_end);
 		void render_bg_tileline16 (__UINT_16 y_offset, __UINT_16 tileline, __UINT_32 attribute, __UINT_8 x_start, __UINT_8 x_end);
@@ -564,6 +598,14 @@ class c_nes_ppu
 
 		void render_po_tileline_16 (__UINT_16, __UINT_16 y_offset, __UINT_16, __UINT_32, __BOOL, __BOOL);
 
+		// The source has to point inside the CHR-ROM (not a page copied into VRAM)
+		void log_chr (__UINT_8 *source, __UINT_8 flags)
+		{
+			nes->o_cdl->log_chr ((__INT_32) (source - &CHRROM [0]), flags);
+		}
+
+		// Each bit of a pattern byte spread to the byte of its pixel
+		static __UINT_32 tileline_spread [256] [2];
 		__UINT_8 unpacked_pixel_data [33*8];
 		s_rendering_information info;
 		s_internal_register reg, lat, reg_backup;
@@ -582,6 +624,12 @@ class c_nes_ppu
 		__UINT_8 *pattern_pages [8];
 		__UINT_16 pattern_pages_backup [8], PatternAddress;
 		__BOOL is_chr_rom;
+		// CHR-ROM pages written to (and copied into VRAM)
+		__UINT_8 dirty_pages;
+		// Registers, banks and mirroring changes (and value at the start of the line)
+		__UINT_32 ppu_writes, line_ppu_writes;
+		// The tiles of the line can be drawn at once
+		__BOOL is_fast_line;
 
 		__UINT_8 bHT, bVT, fv, attribute,
 			   bAttributeShift;
@@ -610,6 +658,11 @@ class c_nes_ppu
 		__UINT_16 spr_tmp_index,
 			    spr_ram_index;
 
+		// Sprites in range of each line (the 9th one raises the overflow),
+		// rebuilt at the start of a line after OAM or the sprites size changed
+		__UINT_8 sprite_lines [256] [9], sprite_lines_count [256];
+		__BOOL is_sprite_lines_dirty;
+
 		__BOOL is_frame_even, state_changed, is_mmc5_vrom;
 
 		c_mem_block VRAM, OAM, TMPOAM, BUFOAM;
@@ -60,6 +60,17 @@ enum EMode
     __READ
 };
 
+// Asynchronous mode: 4MB at most are waiting for the disk,
+// the messages are dropped (and counted) past that
+#define TRACER_CHUNK_SIZE (_32K_ * 8)
+#define TRACER_CHUNKS 16
+
+struct s_tracer_chunk
+{
+	__UINT_32 size;
+	char data [TRACER_CHUNK_SIZE];
+};
+
 union label_dat
 {
 	char string[_1K_];
@@ -79,6 +90,10 @@ class c_tracer
             destination = Type;
         }
 		__INT_32 set_output_file (const char *, EMode Mode = __NEW);
+		// The file is written by another thread
+		void set_async (__BOOL status);
+		// Hands the pending messages to the writer thread
+		void flush (void);
 		
 		void close (void);
 		void f_write (const char *, ...);
@@ -93,12 +108,27 @@ class c_tracer
         }
         label_dat label_read;
 
+		void process_chunks (void);
+
 	private:
 
+		void append (const char *data, __UINT_32 size);
+		void publish_chunk (void);
+
 		Edestination destination;
 		__UINT_32 buffer_pos;
 		FILE *handle;
 		char Buffer [_1K_];
+
+		s_tracer_chunk *chunks;
+		__BOOL filling;
+		__UINT_32 dropped;
+		volatile __UINT_32 chunks_write;
+		volatile __UINT_32 chunks_read;
+		volatile __UINT_32 writer_stop;
+		volatile __UINT_32 writer_idle;
+		void *writer_thread;
+		void *chunks_posted;
 };
 
 #endif
\ No newline at end of file
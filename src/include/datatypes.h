@@ -46,6 +46,9 @@ typedef unsigned short int __BOOL;
 #define TRUE 1
 #define FALSE 0
 
+// Each thread gets its own copy
+#define __THREAD_LOCAL __declspec(thread)
+
 typedef union
 {
 	struct
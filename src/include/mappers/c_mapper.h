@@ -30,7 +30,7 @@
 
 #include "../datatypes.h"
 
-extern c_machine *o_machine;
+extern __THREAD_LOCAL c_machine *o_machine;
 
 class c_mapper {
 
@@ -44,6 +44,7 @@ class c_mapper {
 		virtual void update (void *vData);
 		virtual void h_blank (void);
 
+		// o_head is the chain of the labels already located at that address
 		s_label_node *create_label (s_label_node *o_head, __UINT_16 address, e_dattype type, e_dattype sub_type, int base, int offset, int ref_bank,
                                     int bank_num, int bank_alias)
 		{
@@ -63,9 +64,9 @@ class c_mapper {
                 {
                     return NULL;
                 }
-		        navigator = navigator->Next;
+		        navigator = navigator->Next_Address;
 	        }
-            __NEW (new_label, s_label_node);
+            new_label = nes->BankJMPList->alloc_label ();
             new_label->address = address;
 			new_label->contents = address;
 			new_label->bank = bank_num;
@@ -80,6 +81,7 @@ class c_mapper {
 			new_label->jump_base_table = base;
 			new_label->ref_bank = ref_bank;
             new_label->Next = NULL;
+            new_label->Next_Address = NULL;
             return new_label;
 		}
 
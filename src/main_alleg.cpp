@@ -32,7 +32,8 @@
 /** Global Data                                                              **/
 /******************************************************************************/
 
-c_machine *o_machine;
+// One machine per thread
+__THREAD_LOCAL c_machine *o_machine;
 
 char *ASCII = "APZLGITYEOXUKSVN";
 int nbr_genies_6 = 0;
@@ -45,12 +46,16 @@ void print_usage(void)
     printf(APPNAME " " APPVERSION "\n");
     printf("Copyright (C) 2003-2004 Sadai Sarmiento\n");
     printf("Copyright (C) 2023-2024 Franck \"hitchhikr\" Charlet\n\n");
-    printf("Usage: [L] [J] [-XXXXXX] [-XXXXXXXX] <P|N> <rom file>\n\n");
+    printf("Usage: [L] [J] [D] [-XXXXXX] [-XXXXXXXX] <P|N> <rom file>\n");
+    printf("       T <trace file>\n\n");
     printf("       [L] = Turn instructions logger on at startup\n");
     printf("       [J] = Use 2 pads\n");
+    printf("       [D] = Run the code through the blocks translator\n");
+    printf("             (when the labels and the logger are off)\n");
     printf("       [-XXXXXX] | [-XXXXXXXX] = Specify 6 or 8-char Game Genies\n");
     printf("                                 (Any number of Genies can be used)\n");
-    printf("       <P|N> = PAL|NTSC\n\n");
+    printf("       <P|N> = PAL|NTSC\n");
+    printf("       T = Convert a trace written by the instructions logger to text\n\n");
     printf("       Keys: A=A S=B ENTER=START SPACE=SELECT\n");
     printf("             Arrows=Direction pad\n");
     printf("             (Joystick is supported too)\n");
@@ -60,7 +65,7 @@ void print_usage(void)
     printf("       F7: Decrement current slot number (Total # of slots: 8)\n");
     printf("       F8: Increment current slot number\n");
     printf("       F10: Soft reset\n");
-    printf("       F12: Toggle instructions logger (generates *HUGE* .log).\n");
+    printf("       F12: Toggle instructions logger (generates *HUGE* " APPNAME ".trace).\n");
     printf("       ESC: Quit emulation and start disassembling process\n");
 }
 
@@ -178,6 +183,21 @@ int main (int argc, char *argv[])
 
     printf(APPNAME " " APPVERSION "\n");
 
+    // Doesn't need the emulator
+    if(toupper(argv[pos_arg][0]) == 'T')
+    {
+        char output[1024];
+
+        snprintf(output, sizeof(output), "%s.log", argv[++pos_arg]);
+        if(!c_instruction_trace::render(argv[pos_arg], output))
+        {
+            printf("ERROR: File not found!\n");
+            return -1;
+        }
+        printf("Trace written to %s\n", output);
+        return 0;
+    }
+
 	atexit(&free_everything);
 
 	allegro_init ();
@@ -204,6 +224,13 @@ int main (int argc, char *argv[])
 		pos_arg++;
 	}
 
+	nes->set_dynarec(FALSE);
+	if(toupper(argv[pos_arg][0]) == 'D')
+	{
+		nes->set_dynarec(TRUE);
+		pos_arg++;
+	}
+
     // Store any eventual genies
     while(argv[pos_arg][0] == '-')
     {
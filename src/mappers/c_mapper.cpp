@@ -34,7 +34,7 @@
 /** External Data                                                            **/
 /******************************************************************************/
 
-extern c_machine *o_machine;
+extern __THREAD_LOCAL c_machine *o_machine;
 
 /******************************************************************************/
 /** Installer                                                                **/
@@ -117,13 +117,13 @@ void c_mapper :: load_state (c_tracer &o_reader)
 
 void c_mapper :: set_vectors()
 {
-    if (_2A03_labelHolder)
+    if (_2A03_get_label_holder ())
 	{
 	    nes->BankJMPList->insert_label(vectors_address + 2, TYPE_DATA, TYPE_WORD, 0, 0);
 	    nes->BankJMPList->insert_label(vectors_address + 4, TYPE_DATA, TYPE_WORD, 0, 0);
 	    nes->BankJMPList->insert_label(vectors_address, TYPE_DATA, TYPE_WORD, 0, vectors_address);
-	    nes->BankJMPList->insert_label(resetAddr, TYPE_CODE, TYPE_CODE, 0, 0);
-	    nes->BankJMPList->insert_label(IRQAddr, TYPE_CODE, TYPE_CODE, 0, 0);
-	    nes->BankJMPList->insert_label(NMIAddr, TYPE_CODE, TYPE_CODE, 0, 0);
+	    nes->BankJMPList->insert_label(_2A03_get_reset_address (), TYPE_CODE, TYPE_CODE, 0, 0);
+	    nes->BankJMPList->insert_label(_2A03_get_irq_address (), TYPE_CODE, TYPE_CODE, 0, 0);
+	    nes->BankJMPList->insert_label(_2A03_get_nmi_address (), TYPE_CODE, TYPE_CODE, 0, 0);
     }
 }
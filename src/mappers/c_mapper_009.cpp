@@ -32,7 +32,7 @@
 /** External Data                                                            **/
 /******************************************************************************/
 
-extern c_machine *o_machine;
+extern __THREAD_LOCAL c_machine *o_machine;
 
 c_mapper_009 :: c_mapper_009 (void)
 {